@@ -0,0 +1,591 @@
+#include "GLDispatch.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+#pragma region Native Backend
+
+//The lambdas read the GLEW function pointers when called, so the table is valid before glewInit
+static const GLDispatch nativeTable = {
+#define GL_DISPATCH_NATIVE(Name, ReturnType, Parameters, Arguments) [] Parameters -> ReturnType { return gl##Name Arguments; },
+    GL_DISPATCH_FUNCTIONS (GL_DISPATCH_NATIVE)
+#undef GL_DISPATCH_NATIVE
+#define GL_DISPATCH_NATIVE_CAPABILITY(Name, NativeCondition) [] () -> bool { return NativeCondition; },
+    GL_DISPATCH_CAPABILITIES (GL_DISPATCH_NATIVE_CAPABILITY)
+#undef GL_DISPATCH_NATIVE_CAPABILITY
+};
+
+const GLDispatch* GLDispatch::current = &nativeTable;
+
+const GLDispatch& GLDispatch::Native ()
+{
+    return nativeTable;
+}
+
+void GLDispatch::Install (const GLDispatch& table)
+{
+    current = &table;
+}
+
+#pragma endregion
+
+#pragma region Null Backend
+
+struct NullUniform
+{
+    std::string name;
+    GLenum type;
+    GLint size;
+    GLint location;
+};
+
+struct NullProgram
+{
+    std::vector<GLuint> shaders;
+    std::vector<NullUniform> uniforms;
+    std::unordered_map<std::string, size_t> uniformIndices;
+};
+
+static GLuint nullNextName = 1;
+static std::unordered_map<GLuint, std::vector<NullUniform>> nullShaders;
+static std::unordered_map<GLuint, NullProgram> nullPrograms;
+static std::unordered_map<GLuint, std::vector<unsigned char>> nullBuffers;
+static std::unordered_map<GLenum, GLuint> nullBoundBuffers;
+
+static GLenum NullUniformType (const std::string& typeName)
+{
+    static const std::unordered_map<std::string, GLenum> types = {
+        { "float", GL_FLOAT }, { "vec2", GL_FLOAT_VEC2 }, { "vec3", GL_FLOAT_VEC3 }, { "vec4", GL_FLOAT_VEC4 },
+        { "int", GL_INT }, { "ivec2", GL_INT_VEC2 }, { "ivec3", GL_INT_VEC3 }, { "ivec4", GL_INT_VEC4 },
+        { "uint", GL_UNSIGNED_INT }, { "uvec2", GL_UNSIGNED_INT_VEC2 }, { "uvec3", GL_UNSIGNED_INT_VEC3 }, { "uvec4", GL_UNSIGNED_INT_VEC4 },
+        { "bool", GL_BOOL }, { "bvec2", GL_BOOL_VEC2 }, { "bvec3", GL_BOOL_VEC3 }, { "bvec4", GL_BOOL_VEC4 },
+        { "mat2", GL_FLOAT_MAT2 }, { "mat2x2", GL_FLOAT_MAT2 }, { "mat2x3", GL_FLOAT_MAT2x3 }, { "mat2x4", GL_FLOAT_MAT2x4 },
+        { "mat3x2", GL_FLOAT_MAT3x2 }, { "mat3", GL_FLOAT_MAT3 }, { "mat3x3", GL_FLOAT_MAT3 }, { "mat3x4", GL_FLOAT_MAT3x4 },
+        { "mat4x2", GL_FLOAT_MAT4x2 }, { "mat4x3", GL_FLOAT_MAT4x3 }, { "mat4", GL_FLOAT_MAT4 }, { "mat4x4", GL_FLOAT_MAT4 },
+    };
+
+    auto it = types.find (typeName);
+
+    if (it != types.end ())
+        return it->second;
+
+    //Samplers, images and atomic counters are all set as a single int
+    return GL_SAMPLER_2D;
+}
+
+/// <summary>
+/// Collects the uniforms declared outside blocks in GLSL source, as "uniform type name[size], name = initializer;".
+/// Preprocessor lines are skipped, so uniforms in inactive #if branches are reported too.
+/// </summary>
+static std::vector<NullUniform> NullScanUniforms (const std::string& source)
+{
+    std::vector<std::string> tokens;
+    size_t i = 0;
+
+    while (i < source.size ())
+    {
+        char c = source[i];
+
+        if (source.compare (i, 2, "//") == 0 || c == '#')
+            i = std::min (source.find ('\n', i), source.size ());
+        else if (source.compare (i, 2, "/*") == 0)
+            i = std::min (source.find ("*/", i + 2), source.size () - 2) + 2;
+        else if (std::isalnum (static_cast<unsigned char> (c)) || c == '_')
+        {
+            size_t start = i;
+
+            while (i < source.size () && (std::isalnum (static_cast<unsigned char> (source[i])) || source[i] == '_'))
+                i++;
+
+            tokens.push_back (source.substr (start, i - start));
+        }
+        else
+        {
+            if (!std::isspace (static_cast<unsigned char> (c)))
+                tokens.push_back (std::string (1, c));
+
+            i++;
+        }
+    }
+
+    std::vector<NullUniform> uniforms;
+
+    for (size_t t = 0; t + 2 < tokens.size (); t++)
+    {
+        if (tokens[t] != "uniform")
+            continue;
+
+        size_t next = t + 1;
+
+        while (next < tokens.size () && (tokens[next] == "highp" || tokens[next] == "mediump" || tokens[next] == "lowp"))
+            next++;
+
+        //A block: uniform Name { ... }
+        if (next + 1 >= tokens.size () || tokens[next + 1] == "{")
+            continue;
+
+        GLenum type = NullUniformType (tokens[next]);
+
+        for (next++; next < tokens.size () && tokens[next] != ";"; next++)
+        {
+            if (tokens[next] == ",")
+                continue;
+
+            //An initializer runs to the next declarator or the end of the declaration; commas inside constructors do not end it
+            if (tokens[next] == "=")
+            {
+                int depth = 0;
+
+                for (; next + 1 < tokens.size () && (depth > 0 || (tokens[next + 1] != "," && tokens[next + 1] != ";")); next++)
+                {
+                    if (tokens[next + 1] == "(" || tokens[next + 1] == "[" || tokens[next + 1] == "{")
+                        depth++;
+                    else if (tokens[next + 1] == ")" || tokens[next + 1] == "]" || tokens[next + 1] == "}")
+                        depth--;
+                }
+
+                continue;
+            }
+
+            NullUniform uniform = { tokens[next], type, 1, 0 };
+
+            if (next + 3 < tokens.size () && tokens[next + 1] == "[" && tokens[next + 3] == "]")
+            {
+                uniform.size = std::max (std::atoi (tokens[next + 2].c_str ()), 1);
+                next += 3;
+            }
+
+            uniforms.push_back (std::move (uniform));
+        }
+    }
+
+    return uniforms;
+}
+
+static void NullWriteName (const std::string& name, GLsizei bufSize, GLsizei* length, GLchar* buffer)
+{
+    GLsizei written = bufSize > 0 ? std::min (static_cast<GLsizei> (name.size ()), bufSize - 1) : 0;
+
+    if (bufSize > 0)
+    {
+        std::memcpy (buffer, name.data (), written);
+        buffer[written] = '\0';
+    }
+
+    if (length)
+        *length = written;
+}
+
+static std::string NullReportedName (const NullUniform& uniform)
+{
+    return uniform.size > 1 ? uniform.name + "[0]" : uniform.name;
+}
+
+static GLuint NullCreateProgram ()
+{
+    nullPrograms[nullNextName] = NullProgram ();
+    return nullNextName++;
+}
+
+static void NullDeleteProgram (GLuint program)
+{
+    nullPrograms.erase (program);
+}
+
+static GLuint NullCreateShader (GLenum)
+{
+    nullShaders[nullNextName].clear ();
+    return nullNextName++;
+}
+
+static void NullDeleteShader (GLuint shader)
+{
+    nullShaders.erase (shader);
+}
+
+static void NullShaderSource (GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths)
+{
+    std::string source;
+
+    for (GLsizei i = 0; i < count; i++)
+    {
+        if (lengths && lengths[i] >= 0)
+            source.append (strings[i], lengths[i]);
+        else
+            source.append (strings[i]);
+    }
+
+    nullShaders[shader] = NullScanUniforms (source);
+}
+
+static void NullGetShaderiv (GLuint, GLenum pname, GLint* params)
+{
+    *params = pname == GL_COMPILE_STATUS || pname == GL_COMPLETION_STATUS_KHR ? GL_TRUE : pname == GL_INFO_LOG_LENGTH ? 1 : 0;
+}
+
+static void NullGetInfoLog (GLuint, GLsizei bufSize, GLsizei* length, GLchar* log)
+{
+    NullWriteName (std::string (), bufSize, length, log);
+}
+
+static void NullAttachShader (GLuint program, GLuint shader)
+{
+    nullPrograms[program].shaders.push_back (shader);
+}
+
+static void NullDetachShader (GLuint program, GLuint shader)
+{
+    std::vector<GLuint>& shaders = nullPrograms[program].shaders;
+    shaders.erase (std::remove (shaders.begin (), shaders.end (), shader), shaders.end ());
+}
+
+static void NullLinkProgram (GLuint program)
+{
+    NullProgram& linked = nullPrograms[program];
+    linked.uniforms.clear ();
+    linked.uniformIndices.clear ();
+    GLint location = 0;
+
+    //A uniform declared by several stages is a single uniform of the program
+    for (GLuint shader : linked.shaders)
+    {
+        for (const NullUniform& uniform : nullShaders[shader])
+        {
+            if (!linked.uniformIndices.emplace (uniform.name, linked.uniforms.size ()).second)
+                continue;
+
+            linked.uniforms.push_back ({ uniform.name, uniform.type, uniform.size, location });
+            location += uniform.size;
+        }
+    }
+}
+
+static void NullGetProgramiv (GLuint program, GLenum pname, GLint* params)
+{
+    const NullProgram& linked = nullPrograms[program];
+
+    switch (pname)
+    {
+    case GL_LINK_STATUS:
+    case GL_COMPLETION_STATUS_KHR:
+        *params = GL_TRUE;
+        break;
+    case GL_INFO_LOG_LENGTH:
+        *params = 1;
+        break;
+    case GL_ACTIVE_UNIFORMS:
+        *params = static_cast<GLint> (linked.uniforms.size ());
+        break;
+    case GL_ACTIVE_UNIFORM_MAX_LENGTH:
+        *params = 1;
+
+        for (const NullUniform& uniform : linked.uniforms)
+            *params = std::max (*params, static_cast<GLint> (NullReportedName (uniform).size ()) + 1);
+
+        break;
+    case GL_COMPUTE_WORK_GROUP_SIZE:
+        params[0] = params[1] = params[2] = 1;
+        break;
+    default:
+        *params = 0;
+        break;
+    }
+}
+
+static void NullGetProgramBinary (GLuint, GLsizei, GLsizei* length, GLenum* format, void*)
+{
+    if (length)
+        *length = 0;
+
+    *format = GL_NONE;
+}
+
+static void NullGetActiveUniform (GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+    const NullUniform& uniform = nullPrograms[program].uniforms[index];
+    NullWriteName (NullReportedName (uniform), bufSize, length, name);
+    *size = uniform.size;
+    *type = uniform.type;
+}
+
+static void NullGetActiveUniformsiv (GLuint, GLsizei count, const GLuint*, GLenum, GLint* params)
+{
+    std::fill (params, params + count, 0);
+}
+
+static GLint NullGetUniformLocation (GLuint program, const GLchar* name)
+{
+    const NullProgram& linked = nullPrograms[program];
+    const char* bracket = std::strchr (name, '[');
+    std::string baseName = bracket ? std::string (name, bracket) : std::string (name);
+    GLint element = bracket ? std::atoi (bracket + 1) : 0;
+
+    auto it = linked.uniformIndices.find (baseName);
+
+    if (it == linked.uniformIndices.end ())
+        return -1;
+
+    const NullUniform& uniform = linked.uniforms[it->second];
+    return element >= 0 && element < uniform.size ? uniform.location + element : -1;
+}
+
+static void NullGetIndexedName (GLuint, GLuint, GLsizei bufSize, GLsizei* length, GLchar* name)
+{
+    NullWriteName (std::string (), bufSize, length, name);
+}
+
+static void NullGetActiveUniformBlockiv (GLuint, GLuint, GLenum, GLint* params)
+{
+    *params = 0;
+}
+
+static void NullGetProgramInterfaceiv (GLuint, GLenum, GLenum, GLint* params)
+{
+    *params = 0;
+}
+
+static void NullGetProgramResourceiv (GLuint, GLenum, GLuint, GLsizei propCount, const GLenum*, GLsizei bufSize, GLsizei* length, GLint* params)
+{
+    GLsizei written = std::min (propCount, bufSize);
+    std::fill (params, params + written, 0);
+
+    if (length)
+        *length = written;
+}
+
+static void NullGetProgramResourceName (GLuint, GLenum, GLuint, GLsizei bufSize, GLsizei* length, GLchar* name)
+{
+    NullWriteName (std::string (), bufSize, length, name);
+}
+
+static const GLubyte* NullGetString (GLenum)
+{
+    return reinterpret_cast<const GLubyte*> ("Null");
+}
+
+static void NullGetIntegerv (GLenum pname, GLint* data)
+{
+    //Binding limits are reported at the GL 4.3 minimums, so binding point allocation behaves as on a real driver
+    switch (pname)
+    {
+    case GL_MAX_UNIFORM_BUFFER_BINDINGS:
+        *data = 72;
+        break;
+    case GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS:
+        *data = 8;
+        break;
+    case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:
+        *data = 256;
+        break;
+    default:
+        *data = 0;
+        break;
+    }
+}
+
+static void NullGenNames (GLsizei count, GLuint* names)
+{
+    for (GLsizei i = 0; i < count; i++)
+        names[i] = nullNextName++;
+}
+
+static void NullBindBuffer (GLenum target, GLuint buffer)
+{
+    nullBoundBuffers[target] = buffer;
+}
+
+static void NullDeleteBuffers (GLsizei count, const GLuint* buffers)
+{
+    for (GLsizei i = 0; i < count; i++)
+        nullBuffers.erase (buffers[i]);
+}
+
+//Buffers hold their contents, so that mappings, persistent ones included, point at real memory
+static void NullBufferStorage (GLenum target, GLsizeiptr size, const void* data, GLbitfield)
+{
+    std::vector<unsigned char>& contents = nullBuffers[nullBoundBuffers[target]];
+    contents.assign (size, 0);
+
+    if (data)
+        std::memcpy (contents.data (), data, size);
+}
+
+static void NullBufferData (GLenum target, GLsizeiptr size, const void* data, GLenum)
+{
+    NullBufferStorage (target, size, data, 0);
+}
+
+static void NullBufferSubData (GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    std::memcpy (nullBuffers[nullBoundBuffers[target]].data () + offset, data, size);
+}
+
+static void* NullMapBufferRange (GLenum target, GLintptr offset, GLsizeiptr, GLbitfield)
+{
+    return nullBuffers[nullBoundBuffers[target]].data () + offset;
+}
+
+static GLboolean NullUnmapBuffer (GLenum)
+{
+    return GL_TRUE;
+}
+
+static GLenum NullClientWaitSync (GLsync, GLbitfield, GLuint64)
+{
+    return GL_ALREADY_SIGNALED;
+}
+
+static void NullGetQueryObjectiv (GLuint, GLenum pname, GLint* params)
+{
+    *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+static void NullGetQueryObjectui64v (GLuint, GLenum, GLuint64* params)
+{
+    *params = 0;
+}
+
+template <typename T>
+static T NullResult ()
+{
+    return T ();
+}
+
+template <typename... Arguments>
+static void NullIgnore (const Arguments&...)
+{
+}
+
+static GLDispatch CreateNullTable ()
+{
+    //Entry points without results do nothing; the rest are answered from the state above
+    GLDispatch table = {
+#define GL_DISPATCH_NULL(Name, ReturnType, Parameters, Arguments) [] Parameters -> ReturnType { NullIgnore Arguments; return NullResult<ReturnType> (); },
+        GL_DISPATCH_FUNCTIONS (GL_DISPATCH_NULL)
+#undef GL_DISPATCH_NULL
+#define GL_DISPATCH_NULL_CAPABILITY(Name, NativeCondition) [] () -> bool { return true; },
+        GL_DISPATCH_CAPABILITIES (GL_DISPATCH_NULL_CAPABILITY)
+#undef GL_DISPATCH_NULL_CAPABILITY
+    };
+
+    table.CreateProgram = NullCreateProgram;
+    table.DeleteProgram = NullDeleteProgram;
+    table.CreateShader = NullCreateShader;
+    table.DeleteShader = NullDeleteShader;
+    table.ShaderSource = NullShaderSource;
+    table.GetShaderiv = NullGetShaderiv;
+    table.GetShaderInfoLog = NullGetInfoLog;
+    table.AttachShader = NullAttachShader;
+    table.DetachShader = NullDetachShader;
+    table.LinkProgram = NullLinkProgram;
+    table.GetProgramiv = NullGetProgramiv;
+    table.GetProgramInfoLog = NullGetInfoLog;
+    table.GetProgramBinary = NullGetProgramBinary;
+    table.GetActiveUniform = NullGetActiveUniform;
+    table.GetActiveUniformName = NullGetIndexedName;
+    table.GetActiveUniformsiv = NullGetActiveUniformsiv;
+    table.GetUniformLocation = NullGetUniformLocation;
+    table.GetActiveUniformBlockiv = NullGetActiveUniformBlockiv;
+    table.GetActiveUniformBlockName = NullGetIndexedName;
+    table.GetProgramInterfaceiv = NullGetProgramInterfaceiv;
+    table.GetProgramResourceiv = NullGetProgramResourceiv;
+    table.GetProgramResourceName = NullGetProgramResourceName;
+    table.GetString = NullGetString;
+    table.GetIntegerv = NullGetIntegerv;
+    table.GenProgramPipelines = NullGenNames;
+    table.GenQueries = NullGenNames;
+    table.GenBuffers = NullGenNames;
+    table.DeleteBuffers = NullDeleteBuffers;
+    table.BindBuffer = NullBindBuffer;
+    table.BufferData = NullBufferData;
+    table.BufferSubData = NullBufferSubData;
+    table.BufferStorage = NullBufferStorage;
+    table.MapBufferRange = NullMapBufferRange;
+    table.UnmapBuffer = NullUnmapBuffer;
+    table.ClientWaitSync = NullClientWaitSync;
+    table.GetQueryObjectiv = NullGetQueryObjectiv;
+    table.GetQueryObjectui64v = NullGetQueryObjectui64v;
+
+    return table;
+}
+
+const GLDispatch& GLDispatch::Null ()
+{
+    static const GLDispatch table = CreateNullTable ();
+    return table;
+}
+
+#pragma endregion
+
+#pragma region Recording Backend
+
+static const GLDispatch* recordingTarget = &nativeTable;
+static std::vector<GLDispatch::RecordedCall> recordedCalls;
+
+static void AppendArgument (std::string& text, const char* value)
+{
+    text += value ? "\"" + std::string (value) + "\"" : std::string ("null");
+}
+
+template <typename T>
+static void AppendArgument (std::string& text, T value)
+{
+    if constexpr (std::is_pointer<T>::value)
+    {
+        char address[32];
+        std::snprintf (address, sizeof (address), "%p", static_cast<const void*> (value));
+        text += address;
+    }
+    else if constexpr (std::is_same<T, GLboolean>::value)
+        text += value ? "GL_TRUE" : "GL_FALSE";
+    else
+        text += std::to_string (value);
+}
+
+//Called with the argument list of an entry point, as CallRecorder { "UseProgram" } (program)
+struct CallRecorder
+{
+    const char* function;
+
+    template <typename... Arguments>
+    void operator() (Arguments... arguments) const
+    {
+        std::string text;
+        //Each argument is appended after a separator, and the leading one is dropped
+        ((text += ", ", AppendArgument (text, arguments)), ...);
+        recordedCalls.push_back ({ function, text.size () > 2 ? text.substr (2) : std::string () });
+    }
+};
+
+static const GLDispatch recordingTable = {
+#define GL_DISPATCH_RECORD(Name, ReturnType, Parameters, Arguments) \
+    [] Parameters -> ReturnType { CallRecorder { #Name } Arguments; return recordingTarget->Name Arguments; },
+    GL_DISPATCH_FUNCTIONS (GL_DISPATCH_RECORD)
+#undef GL_DISPATCH_RECORD
+#define GL_DISPATCH_RECORD_CAPABILITY(Name, NativeCondition) [] () -> bool { return recordingTarget->Name (); },
+    GL_DISPATCH_CAPABILITIES (GL_DISPATCH_RECORD_CAPABILITY)
+#undef GL_DISPATCH_RECORD_CAPABILITY
+};
+
+const GLDispatch& GLDispatch::Recording (const GLDispatch& target)
+{
+    recordingTarget = &target;
+    return recordingTable;
+}
+
+const std::vector<GLDispatch::RecordedCall>& GLDispatch::GetRecordedCalls ()
+{
+    return recordedCalls;
+}
+
+void GLDispatch::ClearRecordedCalls ()
+{
+    recordedCalls.clear ();
+}
+
+#pragma endregion
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+/// <summary>
+/// Every GL entry point called by ShaderProgram, ShaderStage, ProgramPipeline, the uniform traits, the uniform, storage and
+/// ring buffers and ShaderProfiler, as X (Name, ReturnType, (Parameters), (Arguments)). The table, its backends and the
+/// forwarding code are all generated from this list.
+/// </summary>
+#define GL_DISPATCH_FUNCTIONS(X)                                                                                                                                      \
+    X (CreateProgram, GLuint, (), ())                                                                                                                                 \
+    X (DeleteProgram, void, (GLuint program), (program))                                                                                                              \
+    X (CreateShader, GLuint, (GLenum type), (type))                                                                                                                   \
+    X (DeleteShader, void, (GLuint shader), (shader))                                                                                                                 \
+    X (ShaderSource, void, (GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths), (shader, count, strings, lengths))                      \
+    X (CompileShader, void, (GLuint shader), (shader))                                                                                                                \
+    X (ShaderBinary, void, (GLsizei count, const GLuint* shaders, GLenum format, const void* binary, GLsizei length), (count, shaders, format, binary, length))       \
+    X (SpecializeShader, void, (GLuint shader, const GLchar* entryPoint, GLuint count, const GLuint* indices, const GLuint* values),                                  \
+       (shader, entryPoint, count, indices, values))                                                                                                                  \
+    X (SpecializeShaderARB, void, (GLuint shader, const GLchar* entryPoint, GLuint count, const GLuint* indices, const GLuint* values),                               \
+       (shader, entryPoint, count, indices, values))                                                                                                                  \
+    X (GetShaderiv, void, (GLuint shader, GLenum pname, GLint* params), (shader, pname, params))                                                                      \
+    X (GetShaderInfoLog, void, (GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* log), (shader, bufSize, length, log))                                        \
+    X (AttachShader, void, (GLuint program, GLuint shader), (program, shader))                                                                                        \
+    X (DetachShader, void, (GLuint program, GLuint shader), (program, shader))                                                                                        \
+    X (LinkProgram, void, (GLuint program), (program))                                                                                                                \
+    X (GetProgramiv, void, (GLuint program, GLenum pname, GLint* params), (program, pname, params))                                                                   \
+    X (GetProgramInfoLog, void, (GLuint program, GLsizei bufSize, GLsizei* length, GLchar* log), (program, bufSize, length, log))                                     \
+    X (ProgramParameteri, void, (GLuint program, GLenum pname, GLint value), (program, pname, value))                                                                 \
+    X (GetProgramBinary, void, (GLuint program, GLsizei bufSize, GLsizei* length, GLenum* format, void* binary), (program, bufSize, length, format, binary))           \
+    X (ProgramBinary, void, (GLuint program, GLenum format, const void* binary, GLsizei length), (program, format, binary, length))                                   \
+    X (UseProgram, void, (GLuint program), (program))                                                                                                                 \
+    X (GetActiveUniform, void, (GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name),                             \
+       (program, index, bufSize, length, size, type, name))                                                                                                           \
+    X (GetActiveUniformName, void, (GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLchar* name), (program, index, bufSize, length, name))           \
+    X (GetActiveUniformsiv, void, (GLuint program, GLsizei count, const GLuint* indices, GLenum pname, GLint* params), (program, count, indices, pname, params))       \
+    X (GetUniformLocation, GLint, (GLuint program, const GLchar* name), (program, name))                                                                              \
+    X (GetActiveUniformBlockiv, void, (GLuint program, GLuint index, GLenum pname, GLint* params), (program, index, pname, params))                                   \
+    X (GetActiveUniformBlockName, void, (GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLchar* name), (program, index, bufSize, length, name))      \
+    X (UniformBlockBinding, void, (GLuint program, GLuint index, GLuint binding), (program, index, binding))                                                          \
+    X (GetProgramInterfaceiv, void, (GLuint program, GLenum programInterface, GLenum pname, GLint* params), (program, programInterface, pname, params))               \
+    X (GetProgramResourceiv, void, (GLuint program, GLenum programInterface, GLuint index, GLsizei propCount, const GLenum* props, GLsizei bufSize, GLsizei* length,  \
+       GLint* params), (program, programInterface, index, propCount, props, bufSize, length, params))                                                                 \
+    X (GetProgramResourceName, void, (GLuint program, GLenum programInterface, GLuint index, GLsizei bufSize, GLsizei* length, GLchar* name),                         \
+       (program, programInterface, index, bufSize, length, name))                                                                                                     \
+    X (ShaderStorageBlockBinding, void, (GLuint program, GLuint index, GLuint binding), (program, index, binding))                                                    \
+    X (GenProgramPipelines, void, (GLsizei count, GLuint* pipelines), (count, pipelines))                                                                             \
+    X (DeleteProgramPipelines, void, (GLsizei count, const GLuint* pipelines), (count, pipelines))                                                                    \
+    X (UseProgramStages, void, (GLuint pipeline, GLbitfield stages, GLuint program), (pipeline, stages, program))                                                     \
+    X (BindProgramPipeline, void, (GLuint pipeline), (pipeline))                                                                                                      \
+    X (ActiveShaderProgram, void, (GLuint pipeline, GLuint program), (pipeline, program))                                                                             \
+    X (BindBuffer, void, (GLenum target, GLuint buffer), (target, buffer))                                                                                            \
+    X (BindBufferBase, void, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer))                                                                   \
+    X (BindBufferRange, void, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), (target, index, buffer, offset, size))                  \
+    X (GenBuffers, void, (GLsizei count, GLuint* buffers), (count, buffers))                                                                                          \
+    X (DeleteBuffers, void, (GLsizei count, const GLuint* buffers), (count, buffers))                                                                                 \
+    X (BufferData, void, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage))                                               \
+    X (BufferSubData, void, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data))                                        \
+    X (BufferStorage, void, (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags), (target, size, data, flags))                                        \
+    X (MapBufferRange, void*, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access))                               \
+    X (UnmapBuffer, GLboolean, (GLenum target), (target))                                                                                                             \
+    X (FenceSync, GLsync, (GLenum condition, GLbitfield flags), (condition, flags))                                                                                   \
+    X (ClientWaitSync, GLenum, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout))                                                             \
+    X (DeleteSync, void, (GLsync sync), (sync))                                                                                                                       \
+    X (DispatchCompute, void, (GLuint x, GLuint y, GLuint z), (x, y, z))                                                                                              \
+    X (DispatchComputeIndirect, void, (GLintptr offset), (offset))                                                                                                    \
+    X (MemoryBarrier, void, (GLbitfield barriers), (barriers))                                                                                                        \
+    X (GetString, const GLubyte*, (GLenum name), (name))                                                                                                              \
+    X (GetIntegerv, void, (GLenum pname, GLint* data), (pname, data))                                                                                                 \
+    X (MaxShaderCompilerThreadsKHR, void, (GLuint count), (count))                                                                                                    \
+    X (MaxShaderCompilerThreadsARB, void, (GLuint count), (count))                                                                                                    \
+    X (GenQueries, void, (GLsizei count, GLuint* ids), (count, ids))                                                                                                  \
+    X (BeginQuery, void, (GLenum target, GLuint id), (target, id))                                                                                                    \
+    X (EndQuery, void, (GLenum target), (target))                                                                                                                     \
+    X (GetQueryObjectiv, void, (GLuint id, GLenum pname, GLint* params), (id, pname, params))                                                                         \
+    X (GetQueryObjectui64v, void, (GLuint id, GLenum pname, GLuint64* params), (id, pname, params))                                                                   \
+    X (Uniform1fv, void, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))                                                             \
+    X (Uniform2fv, void, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))                                                             \
+    X (Uniform3fv, void, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))                                                             \
+    X (Uniform4fv, void, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))                                                             \
+    X (Uniform1iv, void, (GLint location, GLsizei count, const GLint* value), (location, count, value))                                                               \
+    X (Uniform2iv, void, (GLint location, GLsizei count, const GLint* value), (location, count, value))                                                               \
+    X (Uniform3iv, void, (GLint location, GLsizei count, const GLint* value), (location, count, value))                                                               \
+    X (Uniform4iv, void, (GLint location, GLsizei count, const GLint* value), (location, count, value))                                                               \
+    X (Uniform1uiv, void, (GLint location, GLsizei count, const GLuint* value), (location, count, value))                                                             \
+    X (Uniform2uiv, void, (GLint location, GLsizei count, const GLuint* value), (location, count, value))                                                             \
+    X (Uniform3uiv, void, (GLint location, GLsizei count, const GLuint* value), (location, count, value))                                                             \
+    X (Uniform4uiv, void, (GLint location, GLsizei count, const GLuint* value), (location, count, value))                                                             \
+    X (UniformMatrix2fv, void, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))                       \
+    X (UniformMatrix2x3fv, void, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))                     \
+    X (UniformMatrix2x4fv, void, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))                     \
+    X (UniformMatrix3x2fv, void, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))                     \
+    X (UniformMatrix3fv, void, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))                       \
+    X (UniformMatrix3x4fv, void, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))                     \
+    X (UniformMatrix4x2fv, void, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))                     \
+    X (UniformMatrix4x3fv, void, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))                     \
+    X (UniformMatrix4fv, void, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))                       \
+    X (ProgramUniform1fv, void, (GLuint program, GLint location, GLsizei count, const GLfloat* value), (program, location, count, value))                             \
+    X (ProgramUniform2fv, void, (GLuint program, GLint location, GLsizei count, const GLfloat* value), (program, location, count, value))                             \
+    X (ProgramUniform3fv, void, (GLuint program, GLint location, GLsizei count, const GLfloat* value), (program, location, count, value))                             \
+    X (ProgramUniform4fv, void, (GLuint program, GLint location, GLsizei count, const GLfloat* value), (program, location, count, value))                             \
+    X (ProgramUniform1iv, void, (GLuint program, GLint location, GLsizei count, const GLint* value), (program, location, count, value))                               \
+    X (ProgramUniform2iv, void, (GLuint program, GLint location, GLsizei count, const GLint* value), (program, location, count, value))                               \
+    X (ProgramUniform3iv, void, (GLuint program, GLint location, GLsizei count, const GLint* value), (program, location, count, value))                               \
+    X (ProgramUniform4iv, void, (GLuint program, GLint location, GLsizei count, const GLint* value), (program, location, count, value))                               \
+    X (ProgramUniform1uiv, void, (GLuint program, GLint location, GLsizei count, const GLuint* value), (program, location, count, value))                             \
+    X (ProgramUniform2uiv, void, (GLuint program, GLint location, GLsizei count, const GLuint* value), (program, location, count, value))                             \
+    X (ProgramUniform3uiv, void, (GLuint program, GLint location, GLsizei count, const GLuint* value), (program, location, count, value))                             \
+    X (ProgramUniform4uiv, void, (GLuint program, GLint location, GLsizei count, const GLuint* value), (program, location, count, value))                             \
+    X (ProgramUniformMatrix2fv, void, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),                                     \
+       (program, location, count, transpose, value))                                                                                                                  \
+    X (ProgramUniformMatrix2x3fv, void, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),                                   \
+       (program, location, count, transpose, value))                                                                                                                  \
+    X (ProgramUniformMatrix2x4fv, void, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),                                   \
+       (program, location, count, transpose, value))                                                                                                                  \
+    X (ProgramUniformMatrix3x2fv, void, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),                                   \
+       (program, location, count, transpose, value))                                                                                                                  \
+    X (ProgramUniformMatrix3fv, void, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),                                     \
+       (program, location, count, transpose, value))                                                                                                                  \
+    X (ProgramUniformMatrix3x4fv, void, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),                                   \
+       (program, location, count, transpose, value))                                                                                                                  \
+    X (ProgramUniformMatrix4x2fv, void, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),                                   \
+       (program, location, count, transpose, value))                                                                                                                  \
+    X (ProgramUniformMatrix4x3fv, void, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),                                   \
+       (program, location, count, transpose, value))                                                                                                                  \
+    X (ProgramUniformMatrix4fv, void, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),                                     \
+       (program, location, count, transpose, value))
+
+/// <summary>
+/// Every GL version or extension check made by the library, as X (Name, NativeCondition). The native backend evaluates the
+/// GLEW condition; the null backend reports everything as supported, so the paths behind the checks run without a context.
+/// </summary>
+#define GL_DISPATCH_CAPABILITIES(X)                                                                                                                                   \
+    X (HasSeparatePrograms, (GLEW_VERSION_4_1 || GLEW_ARB_separate_shader_objects))                                                                                   \
+    X (HasComputeShaders, (GLEW_VERSION_4_3 || GLEW_ARB_compute_shader))                                                                                              \
+    X (HasStorageBlocks, (GLEW_VERSION_4_3 || (GLEW_ARB_shader_storage_buffer_object && GLEW_ARB_program_interface_query)))                                           \
+    X (HasBufferStorage, (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage))                                                                                               \
+    X (HasSpirv, (GLEW_VERSION_4_6 || GLEW_ARB_gl_spirv))                                                                                                             \
+    X (HasCoreSpirv, (GLEW_VERSION_4_6))                                                                                                                              \
+    X (HasParallelCompile, (GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile))                                                                    \
+    X (HasKHRParallelCompile, (GLEW_KHR_parallel_shader_compile))                                                                                                     \
+    X (HasTimerQueries, (GLEW_VERSION_3_3 || GLEW_ARB_timer_query))
+
+/// <summary>
+/// A table of the GL entry points and capability checks used by this library. The library calls GL through the installed table, so GL can be
+/// replaced by a null backend that needs no context or GPU, or wrapped by a recording backend that logs the call stream.
+/// The installed table is process-wide; install it before creating any program and do not change it while programs exist.
+/// </summary>
+struct GLDispatch
+{
+#define GL_DISPATCH_MEMBER(Name, ReturnType, Parameters, Arguments) ReturnType (*Name) Parameters;
+    GL_DISPATCH_FUNCTIONS (GL_DISPATCH_MEMBER)
+#undef GL_DISPATCH_MEMBER
+
+    //Capability checks, called as GL ().HasComputeShaders ()
+#define GL_DISPATCH_CAPABILITY(Name, NativeCondition) bool (*Name) ();
+    GL_DISPATCH_CAPABILITIES (GL_DISPATCH_CAPABILITY)
+#undef GL_DISPATCH_CAPABILITY
+
+    /// <summary>
+    /// A call made through the recording backend: the entry point without its gl prefix and its arguments as text.
+    /// </summary>
+    struct RecordedCall
+    {
+        const char* function;
+        std::string arguments;
+    };
+
+private:
+    static const GLDispatch* current;
+
+public:
+    /// <summary>
+    /// The backend calling the GL driver through GLEW. Installed by default.
+    /// </summary>
+    static const GLDispatch& Native ();
+
+    /// <summary>
+    /// A backend that needs no context: it hands out fresh object names, reports every compile and link as successful,
+    /// reflects the non-block uniforms declared in the shader sources with consecutive locations, and keeps buffer contents in
+    /// memory so they can be mapped. Everything else does nothing. Every capability is reported as supported.
+    /// </summary>
+    static const GLDispatch& Null ();
+
+    /// <summary>
+    /// A backend that logs every call and then forwards it to another backend. Capability checks are forwarded without being logged.
+    /// </summary>
+    /// <param name="target">The backend to forward to, usually Native () or Null ().</param>
+    static const GLDispatch& Recording (const GLDispatch& target);
+
+    /// <summary>
+    /// Returns the calls logged by the recording backend since the last ClearRecordedCalls, in order.
+    /// </summary>
+    static const std::vector<RecordedCall>& GetRecordedCalls ();
+
+    /// <summary>
+    /// Discards the calls logged by the recording backend.
+    /// </summary>
+    static void ClearRecordedCalls ();
+
+    /// <summary>
+    /// Routes every GL call made by the library through a table.
+    /// </summary>
+    static void Install (const GLDispatch& table);
+
+    /// <summary>
+    /// Returns the installed table.
+    /// </summary>
+    static const GLDispatch& Current ()
+    {
+        return *current;
+    }
+};
+
+/// <summary>
+/// Shorthand for the installed table, as in GL ().UseProgram (programID).
+/// </summary>
+inline const GLDispatch& GL ()
+{
+    return GLDispatch::Current ();
+}
@@ -0,0 +1,139 @@
+#include "ProgramPipeline.h"
+
+#include <iostream>
+
+#include "GLDispatch.h"
+
+std::map<ProgramPipeline::StagePrograms, std::unique_ptr<ProgramPipeline>> ProgramPipeline::pipelines;
+ProgramPipeline::CacheStats ProgramPipeline::cacheStats = {};
+thread_local GLuint ProgramPipeline::boundPipelineID = 0;
+
+static const GLenum stageTypes[] = { GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER };
+static const GLbitfield stageBits[] = { GL_VERTEX_SHADER_BIT, GL_GEOMETRY_SHADER_BIT, GL_FRAGMENT_SHADER_BIT };
+
+ProgramPipeline::~ProgramPipeline ()
+{
+    if (boundPipelineID == pipelineID)
+        boundPipelineID = 0;
+
+    GL ().DeleteProgramPipelines (1, &pipelineID);
+}
+
+void ProgramPipeline::CheckStage (const ShaderProgram* program, GLenum stageType)
+{
+    if (program->GetSeparableStage () != stageType)
+    {
+        std::cerr << "Shader program " << program->programName << " is not a separable program of the stage it is used for in a pipeline\n";
+        exit (EXIT_FAILURE);
+    }
+}
+
+ProgramPipeline& ProgramPipeline::Get (const StagePrograms& programs)
+{
+    auto it = pipelines.find (programs);
+
+    if (it != pipelines.end ())
+    {
+        cacheStats.hits++;
+        return *it->second;
+    }
+
+    cacheStats.misses++;
+
+    for (size_t i = 0; i < programs.size (); i++)
+    {
+        if (programs[i])
+            CheckStage (programs[i], stageTypes[i]);
+    }
+
+    std::unique_ptr<ProgramPipeline> pipeline (new ProgramPipeline ());
+    pipeline->programs = programs;
+    GL ().GenProgramPipelines (1, &pipeline->pipelineID);
+    pipeline->AttachStages ();
+
+    return *pipelines.emplace (programs, std::move (pipeline)).first->second;
+}
+
+ProgramPipeline& ProgramPipeline::Get (const ShaderProgram& vertexProgram, const ShaderProgram& fragmentProgram)
+{
+    return Get (StagePrograms { &vertexProgram, nullptr, &fragmentProgram });
+}
+
+ProgramPipeline& ProgramPipeline::Get (const ShaderProgram& vertexProgram, const ShaderProgram& geometryProgram, const ShaderProgram& fragmentProgram)
+{
+    return Get (StagePrograms { &vertexProgram, &geometryProgram, &fragmentProgram });
+}
+
+void ProgramPipeline::Forget (const ShaderProgram* program)
+{
+    for (auto it = pipelines.begin (); it != pipelines.end ();)
+    {
+        if (it->first[0] == program || it->first[1] == program || it->first[2] == program)
+            it = pipelines.erase (it);
+        else
+            ++it;
+    }
+}
+
+ProgramPipeline::CacheStats ProgramPipeline::GetCacheStats ()
+{
+    return cacheStats;
+}
+
+size_t ProgramPipeline::GetCachedCount ()
+{
+    return pipelines.size ();
+}
+
+void ProgramPipeline::AttachStages () const
+{
+    for (size_t i = 0; i < programs.size (); i++)
+    {
+        GLuint programID = programs[i] ? programs[i]->programID : 0;
+
+        if (programID != attachedIDs[i])
+            GL ().UseProgramStages (pipelineID, stageBits[i], programID);
+
+        attachedIDs[i] = programID;
+    }
+}
+
+void ProgramPipeline::Bind () const
+{
+    //A reload swaps in a new program name under the same ShaderProgram
+    for (size_t i = 0; i < programs.size (); i++)
+    {
+        if (programs[i] && programs[i]->programID != attachedIDs[i])
+        {
+            AttachStages ();
+            break;
+        }
+    }
+
+    //A program bound with glUseProgram overrides the bound pipeline
+    if (ShaderProgram::boundProgramID != 0)
+    {
+        GL ().UseProgram (0);
+        ShaderProgram::boundProgramID = 0;
+
+        //Work done through the pipeline is not charged to the program that was bound
+        if (ShaderProfiler::IsEnabled ())
+            ShaderProfiler::EndRange ();
+    }
+
+    if (boundPipelineID == pipelineID)
+        return;
+
+    GL ().BindProgramPipeline (pipelineID);
+    boundPipelineID = pipelineID;
+}
+
+void ProgramPipeline::SetActiveProgram (const ShaderProgram& program) const
+{
+    GL ().ActiveShaderProgram (pipelineID, program.programID);
+}
+
+GLuint ProgramPipeline::GetPipelineID () const
+{
+    return pipelineID;
+}
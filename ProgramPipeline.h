@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+#include <GL/glew.h>
+
+#include "ShaderProgram.h"
+
+/// <summary>
+/// A program pipeline object combining separable single-stage programs.
+/// Pipelines are cached by their combination of programs, so asking for the same combination again returns the same pipeline.
+/// </summary>
+class ProgramPipeline
+{
+public:
+    /// <summary>
+    /// Counts pipeline lookups served from the cache (hits) and pipelines created (misses).
+    /// </summary>
+    struct CacheStats
+    {
+        std::uint64_t hits;
+        std::uint64_t misses;
+    };
+
+private:
+    // The vertex, geometry and fragment programs of a pipeline; the geometry program may be null
+    typedef std::array<const ShaderProgram*, 3> StagePrograms;
+
+    static std::map<StagePrograms, std::unique_ptr<ProgramPipeline>> pipelines;
+    static CacheStats cacheStats;
+
+    // The pipeline last bound through Bind, tracked per thread like ShaderProgram::UseProgram
+    static thread_local GLuint boundPipelineID;
+
+    GLuint pipelineID;
+    StagePrograms programs;
+
+    // The program names attached to each stage, so a program replaced by a hot reload is attached again on the next Bind
+    mutable std::array<GLuint, 3> attachedIDs = {};
+
+    ProgramPipeline () = default;
+
+    static ProgramPipeline& Get (const StagePrograms& programs);
+    static void CheckStage (const ShaderProgram* program, GLenum stageType);
+    void AttachStages () const;
+
+public:
+    ~ProgramPipeline ();
+
+    ProgramPipeline (const ProgramPipeline&) = delete;
+    ProgramPipeline& operator= (const ProgramPipeline&) = delete;
+
+    /// <summary>
+    /// Returns the pipeline combining a separable vertex program and a separable fragment program, creating it on first use.
+    /// Exits if a program is not separable or is of the wrong stage.
+    /// </summary>
+    static ProgramPipeline& Get (const ShaderProgram& vertexProgram, const ShaderProgram& fragmentProgram);
+
+    /// <summary>
+    /// Returns the pipeline combining separable vertex, geometry and fragment programs, creating it on first use.
+    /// Exits if a program is not separable or is of the wrong stage.
+    /// </summary>
+    static ProgramPipeline& Get (const ShaderProgram& vertexProgram, const ShaderProgram& geometryProgram, const ShaderProgram& fragmentProgram);
+
+    /// <summary>
+    /// Destroys every cached pipeline that uses a program. Called when a separable program is destroyed.
+    /// </summary>
+    static void Forget (const ShaderProgram* program);
+
+    /// <summary>
+    /// Returns how many Get calls were served from the cache and how many created a pipeline.
+    /// </summary>
+    static CacheStats GetCacheStats ();
+
+    /// <summary>
+    /// Returns the number of cached pipelines.
+    /// </summary>
+    static size_t GetCachedCount ();
+
+    /// <summary>
+    /// Makes the pipeline current, unbinding any program set through UseProgram, which would otherwise take precedence.
+    /// Does nothing if the pipeline is already bound in the current context.
+    /// </summary>
+    void Bind () const;
+
+    /// <summary>
+    /// Directs the uniform setters of ShaderProgram to one of the pipeline's programs.
+    /// Call this before setting the uniforms of a stage program while the pipeline is bound.
+    /// </summary>
+    /// <param name="program">A program of the pipeline.</param>
+    void SetActiveProgram (const ShaderProgram& program) const;
+
+    /// <summary>
+    /// Returns the GL name of the pipeline.
+    /// </summary>
+    GLuint GetPipelineID () const;
+};
@@ -0,0 +1,284 @@
+#include "ShaderBundle.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <tuple>
+
+#include "ShaderSource.h"
+#include "SourceHash.h"
+
+std::shared_ptr<const ShaderBundle> ShaderBundle::mounted;
+
+//The header is followed by the index, then the paths, then the contents of every entry, each aligned for direct use
+static const char bundleMagic[4] = { 'S', 'B', 'D', 'L' };
+static const std::uint32_t bundleVersion = 1;
+static const std::uint64_t bundleAlignment = 16;
+
+struct BundleHeader
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t entryCount;
+    std::uint32_t reserved;
+    std::uint64_t indexOffset;
+    std::uint64_t fileSize;
+};
+
+static std::uint64_t AlignOffset (std::uint64_t offset)
+{
+    return (offset + bundleAlignment - 1) / bundleAlignment * bundleAlignment;
+}
+
+ShaderBundle::ShaderBundle (const std::string& filename)
+    : file (filename)
+{
+}
+
+std::unique_ptr<ShaderBundle> ShaderBundle::Open (const std::string& filename)
+{
+    std::unique_ptr<ShaderBundle> bundle (new ShaderBundle (filename));
+
+    if (!bundle->file.IsOpen ())
+    {
+        std::cerr << "Could not open shader bundle: " << filename << "\n";
+        return nullptr;
+    }
+
+    if (!bundle->Validate (filename))
+        return nullptr;
+
+    return bundle;
+}
+
+bool ShaderBundle::Validate (const std::string& filename)
+{
+    const char* data = file.GetData ();
+    size_t size = file.GetSize ();
+    BundleHeader header;
+
+    if (size < sizeof (header))
+    {
+        std::cerr << "Not a shader bundle: " << filename << "\n";
+        return false;
+    }
+
+    std::memcpy (&header, data, sizeof (header));
+
+    if (std::memcmp (header.magic, bundleMagic, sizeof (bundleMagic)) != 0)
+    {
+        std::cerr << "Not a shader bundle: " << filename << "\n";
+        return false;
+    }
+
+    if (header.version != bundleVersion)
+    {
+        std::cerr << "Unsupported shader bundle version " << header.version << ": " << filename << "\n";
+        return false;
+    }
+
+    //Every offset is checked once here, so lookups can trust the index
+    bool valid = header.fileSize == size && header.indexOffset % alignof (IndexEntry) == 0 && header.indexOffset <= size
+        && header.entryCount <= (size - header.indexOffset) / sizeof (IndexEntry);
+
+    if (valid)
+    {
+        index = reinterpret_cast<const IndexEntry*> (data + header.indexOffset);
+        entryCount = header.entryCount;
+    }
+
+    for (std::uint32_t i = 0; valid && i < entryCount; i++)
+    {
+        const IndexEntry& entry = index[i];
+        valid = entry.kind <= static_cast<std::uint32_t> (EntryKind::Binary)
+            && entry.pathOffset <= size && entry.pathLength <= size - entry.pathOffset
+            && entry.dataOffset <= size && entry.dataSize <= size - entry.dataOffset
+            && entry.pathHash == HashText (data + entry.pathOffset, entry.pathLength);
+
+        if (valid && i > 0)
+        {
+            const IndexEntry& previous = index[i - 1];
+            valid = std::make_tuple (previous.kind, previous.pathHash, std::string (data + previous.pathOffset, previous.pathLength))
+                < std::make_tuple (entry.kind, entry.pathHash, std::string (data + entry.pathOffset, entry.pathLength));
+        }
+    }
+
+    if (!valid)
+    {
+        std::cerr << "Corrupt shader bundle: " << filename << "\n";
+        index = nullptr;
+        entryCount = 0;
+        return false;
+    }
+
+    return true;
+}
+
+bool ShaderBundle::Write (const std::string& filename, const std::vector<PackedEntry>& entries)
+{
+    struct Pending
+    {
+        IndexEntry entry;
+        std::string path;
+        const std::vector<char>* contents;
+    };
+
+    std::vector<Pending> pending;
+    pending.reserve (entries.size ());
+
+    for (const PackedEntry& packed : entries)
+    {
+        std::string path = packed.kind == EntryKind::File ? ShaderSource::NormalizePath (packed.path) : packed.path;
+        IndexEntry entry = { static_cast<std::uint32_t> (packed.kind), static_cast<std::uint32_t> (path.size ()), HashString (path), 0, 0, packed.contents.size () };
+        pending.push_back ({ entry, std::move (path), &packed.contents });
+    }
+
+    auto order = [] (const Pending& a, const Pending& b)
+    {
+        return std::tie (a.entry.kind, a.entry.pathHash, a.path) < std::tie (b.entry.kind, b.entry.pathHash, b.path);
+    };
+
+    //A stable sort keeps duplicates in the order given, so the last of each run is the one kept
+    std::stable_sort (pending.begin (), pending.end (), order);
+
+    std::vector<Pending> unique;
+
+    for (Pending& item : pending)
+    {
+        if (!unique.empty () && !order (unique.back (), item))
+            unique.back () = std::move (item);
+        else
+            unique.push_back (std::move (item));
+    }
+
+    BundleHeader header = {};
+    std::memcpy (header.magic, bundleMagic, sizeof (bundleMagic));
+    header.version = bundleVersion;
+    header.entryCount = static_cast<std::uint32_t> (unique.size ());
+    header.indexOffset = sizeof (BundleHeader);
+
+    std::uint64_t offset = header.indexOffset + unique.size () * sizeof (IndexEntry);
+
+    for (Pending& item : unique)
+    {
+        item.entry.pathOffset = offset;
+        offset += item.path.size ();
+    }
+
+    for (Pending& item : unique)
+    {
+        offset = AlignOffset (offset);
+        item.entry.dataOffset = offset;
+        offset += item.entry.dataSize;
+    }
+
+    header.fileSize = offset;
+
+    //Write to a temporary file first so an interrupted write never leaves a truncated bundle behind
+    std::string temporaryPath = filename + ".tmp";
+
+    {
+        std::ofstream stream (temporaryPath, std::ios::binary | std::ios::trunc);
+
+        if (!stream.is_open ())
+        {
+            std::cerr << "Could not write shader bundle: " << temporaryPath << "\n";
+            return false;
+        }
+
+        stream.write (reinterpret_cast<const char*> (&header), sizeof (header));
+
+        for (const Pending& item : unique)
+            stream.write (reinterpret_cast<const char*> (&item.entry), sizeof (item.entry));
+
+        for (const Pending& item : unique)
+            stream.write (item.path.data (), item.path.size ());
+
+        static const char padding[bundleAlignment] = {};
+
+        for (const Pending& item : unique)
+        {
+            stream.write (padding, item.entry.dataOffset - static_cast<std::uint64_t> (stream.tellp ()));
+            stream.write (item.contents->data (), item.contents->size ());
+        }
+
+        if (!stream)
+        {
+            std::cerr << "Could not write shader bundle: " << temporaryPath << "\n";
+            return false;
+        }
+    }
+
+    std::remove (filename.c_str ());
+
+    if (std::rename (temporaryPath.c_str (), filename.c_str ()) != 0)
+    {
+        std::cerr << "Could not write shader bundle: " << filename << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool ShaderBundle::Mount (const std::string& filename)
+{
+    std::unique_ptr<ShaderBundle> bundle = ShaderBundle::Open (filename);
+
+    if (!bundle)
+        return false;
+
+    //Files parsed from loose copies before the mount would otherwise shadow the bundle
+    ShaderSource::InvalidateAllFiles ();
+    mounted = std::move (bundle);
+    return true;
+}
+
+void ShaderBundle::Unmount ()
+{
+    if (!mounted)
+        return;
+
+    //Cached fragments hold the bundle alive until they are dropped, and later programs read loose files again
+    ShaderSource::InvalidateAllFiles ();
+    mounted.reset ();
+}
+
+bool ShaderBundle::Find (EntryKind kind, const std::string& path, const char*& data, size_t& size) const
+{
+    std::string key = kind == EntryKind::File ? ShaderSource::NormalizePath (path) : path;
+    std::uint32_t kindValue = static_cast<std::uint32_t> (kind);
+    std::uint64_t hash = HashString (key);
+    const char* base = file.GetData ();
+
+    const IndexEntry* end = index + entryCount;
+    const IndexEntry* entry = std::lower_bound (index, end, hash, [kindValue] (const IndexEntry& candidate, std::uint64_t hash)
+    {
+        return std::tie (candidate.kind, candidate.pathHash) < std::tie (kindValue, hash);
+    });
+
+    //Paths that share a hash are adjacent, so the scan stops at the first entry of another hash
+    for (; entry != end && entry->kind == kindValue && entry->pathHash == hash; entry++)
+    {
+        if (entry->pathLength != key.size () || std::memcmp (base + entry->pathOffset, key.data (), key.size ()) != 0)
+            continue;
+
+        data = base + entry->dataOffset;
+        size = static_cast<size_t> (entry->dataSize);
+        return true;
+    }
+
+    return false;
+}
+
+size_t ShaderBundle::GetEntryCount () const
+{
+    return entryCount;
+}
+
+std::string ShaderBundle::GetEntryPath (size_t entry, EntryKind& kind) const
+{
+    kind = static_cast<EntryKind> (index[entry].kind);
+    return std::string (file.GetData () + index[entry].pathOffset, index[entry].pathLength);
+}
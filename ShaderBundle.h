@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SourceFile.h"
+
+/// <summary>
+/// A read-only archive of shader files and cached program binaries, written offline by the bundle packer and memory-mapped
+/// whole at startup. While a bundle is mounted, shader sources, includes and SPIR-V modules are resolved through its index
+/// rather than opened one by one, and sources are passed to GL straight out of the mapping.
+/// Files are looked up by the path the program was created with, after folding "\" to "/" and resolving "." and "..".
+/// </summary>
+class ShaderBundle
+{
+public:
+    /// <summary>
+    /// The namespace of an entry: a shader file, looked up by path, or a program binary, looked up by its binary cache key.
+    /// </summary>
+    enum class EntryKind : std::uint32_t
+    {
+        File = 0,
+        Binary = 1
+    };
+
+    /// <summary>
+    /// A file to pack, as passed to Write.
+    /// </summary>
+    struct PackedEntry
+    {
+        EntryKind kind;
+        std::string path;
+        std::vector<char> contents;
+    };
+
+private:
+    // The index entry of one file, as stored in the bundle; entries are sorted by kind, path hash and path
+    struct IndexEntry
+    {
+        std::uint32_t kind;
+        std::uint32_t pathLength;
+        std::uint64_t pathHash;
+        std::uint64_t pathOffset;
+        std::uint64_t dataOffset;
+        std::uint64_t dataSize;
+    };
+
+    static std::shared_ptr<const ShaderBundle> mounted;
+
+    SourceFile file;
+    const IndexEntry* index = nullptr;
+    std::uint32_t entryCount = 0;
+
+    explicit ShaderBundle (const std::string& filename);
+
+    bool Validate (const std::string& filename);
+
+public:
+    ShaderBundle (const ShaderBundle&) = delete;
+    ShaderBundle& operator= (const ShaderBundle&) = delete;
+
+    /// <summary>
+    /// Opens and maps a bundle. Returns null, after reporting why, if the file cannot be read or is not a valid bundle.
+    /// </summary>
+    /// <param name="filename">The bundle file.</param>
+    static std::unique_ptr<ShaderBundle> Open (const std::string& filename);
+
+    /// <summary>
+    /// Writes a bundle. Returns false, after reporting why, if the file cannot be written. Later entries replace earlier ones of the same kind and path.
+    /// </summary>
+    /// <param name="filename">The bundle file.</param>
+    /// <param name="entries">The files and binaries to pack.</param>
+    static bool Write (const std::string& filename, const std::vector<PackedEntry>& entries);
+
+    /// <summary>
+    /// Mounts a bundle, replacing the one mounted before, so that programs created from now on resolve their files through it.
+    /// Returns false, leaving the previous bundle mounted, if the bundle cannot be opened.
+    /// </summary>
+    /// <param name="filename">The bundle file.</param>
+    static bool Mount (const std::string& filename);
+
+    /// <summary>
+    /// Unmounts the mounted bundle. Programs created from now on read loose files again.
+    /// </summary>
+    static void Unmount ();
+
+    /// <summary>
+    /// Returns the mounted bundle, or null if none is mounted. Holding the pointer keeps the mapping alive after an unmount.
+    /// </summary>
+    static const std::shared_ptr<const ShaderBundle>& GetMounted ()
+    {
+        return mounted;
+    }
+
+    /// <summary>
+    /// Looks up an entry. Returns false if the bundle does not hold it; otherwise points data at its contents in the mapping.
+    /// </summary>
+    /// <param name="kind">The namespace of the entry.</param>
+    /// <param name="path">The path of a file, or the key of a binary. Paths are normalized before the lookup.</param>
+    /// <param name="data">Set to the contents, which stay valid as long as the bundle does. They are not null-terminated.</param>
+    /// <param name="size">Set to the size of the contents in bytes.</param>
+    bool Find (EntryKind kind, const std::string& path, const char*& data, size_t& size) const;
+
+    /// <summary>
+    /// Returns the number of entries in the bundle.
+    /// </summary>
+    size_t GetEntryCount () const;
+
+    /// <summary>
+    /// Returns the kind and path of an entry, in index order.
+    /// </summary>
+    /// <param name="entry">The index of the entry, less than GetEntryCount.</param>
+    /// <param name="kind">Set to the kind of the entry.</param>
+    std::string GetEntryPath (size_t entry, EntryKind& kind) const;
+};
@@ -0,0 +1,100 @@
+#include "ShaderLibrary.h"
+
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+static double MillisecondsSince (std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ();
+}
+
+ShaderLibrary::ProgramDescription ShaderLibrary::BasicProgram (const std::string& programName)
+{
+    return { programName, programName + ".vert", "", programName + ".frag" };
+}
+
+ShaderLibrary::ProgramDescription ShaderLibrary::ProgramWithGeometry (const std::string& programName)
+{
+    return { programName, programName + ".vert", programName + ".geom", programName + ".frag" };
+}
+
+std::unique_ptr<ShaderLibrary> ShaderLibrary::Build (const std::vector<ProgramDescription>& manifest)
+{
+    std::unique_ptr<ShaderLibrary> library (new ShaderLibrary ());
+    auto buildStart = std::chrono::steady_clock::now ();
+
+    library->programs.reserve (manifest.size ());
+    library->timings.assign (manifest.size (), {});
+
+    for (size_t i = 0; i < manifest.size (); i++)
+    {
+        const ProgramDescription& description = manifest[i];
+
+        if (!library->programIndices.emplace (description.programName, i).second)
+        {
+            std::cerr << "Duplicate shader program in library: " << description.programName << "\n";
+            exit (EXIT_FAILURE);
+        }
+
+        auto start = std::chrono::steady_clock::now ();
+        std::unique_ptr<ShaderProgram> program = ShaderProgram::SubmitStages (description.programName, description.vertexFilename, description.geometryFilename, description.fragmentFilename);
+
+        if (!program)
+            exit (EXIT_FAILURE);
+
+        library->programs.push_back (std::move (program));
+        library->timings[i].compileMilliseconds = MillisecondsSince (start);
+    }
+
+    for (size_t i = 0; i < manifest.size (); i++)
+    {
+        ShaderProgram& program = *library->programs[i];
+
+        if (program.loadedFromBinaryCache)
+            continue;
+
+        auto start = std::chrono::steady_clock::now ();
+        program.LinkProgram ();
+        library->timings[i].linkMilliseconds = MillisecondsSince (start);
+    }
+
+    for (size_t i = 0; i < manifest.size (); i++)
+    {
+        auto start = std::chrono::steady_clock::now ();
+
+        if (!library->programs[i]->CheckLinkStatus ())
+            exit (EXIT_FAILURE);
+
+        library->timings[i].statusMilliseconds = MillisecondsSince (start);
+    }
+
+    library->buildMilliseconds = MillisecondsSince (buildStart);
+
+    return library;
+}
+
+ShaderProgram* ShaderLibrary::GetProgram (const std::string& programName) const
+{
+    auto it = programIndices.find (programName);
+
+    if (it == programIndices.end ())
+        return nullptr;
+
+    return programs[it->second].get ();
+}
+
+const ShaderLibrary::ProgramTiming& ShaderLibrary::GetTiming (const std::string& programName) const
+{
+    return timings[programIndices.at (programName)];
+}
+
+double ShaderLibrary::GetBuildMilliseconds () const
+{
+    return buildMilliseconds;
+}
+
+const std::vector<std::unique_ptr<ShaderProgram>>& ShaderLibrary::GetPrograms () const
+{
+    return programs;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ShaderProgram.h"
+
+/// <summary>
+/// A set of shader programs built together. All stages of all programs are compiled first, then all programs are linked,
+/// and only then are the results collected, so the driver can overlap the work of different programs.
+/// </summary>
+class ShaderLibrary
+{
+public:
+    /// <summary>
+    /// Describes one program of the library. A program without a geometry shader has an empty geometryFilename.
+    /// </summary>
+    struct ProgramDescription
+    {
+        std::string programName;
+        std::string vertexFilename;
+        std::string geometryFilename;
+        std::string fragmentFilename;
+    };
+
+    /// <summary>
+    /// CPU time spent on one program in each phase of the build, in milliseconds.
+    /// Compile covers loading the sources and submitting them; status covers waiting for the driver and collecting the results.
+    /// </summary>
+    struct ProgramTiming
+    {
+        double compileMilliseconds;
+        double linkMilliseconds;
+        double statusMilliseconds;
+    };
+
+private:
+    std::vector<std::unique_ptr<ShaderProgram>> programs;
+    std::vector<ProgramTiming> timings;
+    std::unordered_map<std::string, size_t> programIndices;
+    double buildMilliseconds;
+
+    ShaderLibrary () = default;
+
+public:
+    /// <summary>
+    /// Describes a program with vertex and fragment shaders named programName + ".vert" and programName + ".frag".
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    static ProgramDescription BasicProgram (const std::string& programName);
+
+    /// <summary>
+    /// Describes a program with vertex, geometry and fragment shaders named programName + ".vert", programName + ".geom" and programName + ".frag".
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    static ProgramDescription ProgramWithGeometry (const std::string& programName);
+
+    /// <summary>
+    /// Builds every program of a manifest. Exits on the first compile or link error, like the ShaderProgram factory constructors.
+    /// </summary>
+    /// <param name="manifest">The programs to build. Program names must be unique.</param>
+    static std::unique_ptr<ShaderLibrary> Build (const std::vector<ProgramDescription>& manifest);
+
+    /// <summary>
+    /// Returns the program with the given name, or nullptr if the library has no such program.
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    ShaderProgram* GetProgram (const std::string& programName) const;
+
+    /// <summary>
+    /// Returns the build timing of the program with the given name. The program must be in the library.
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    const ProgramTiming& GetTiming (const std::string& programName) const;
+
+    /// <summary>
+    /// Returns the wall time of the whole build, in milliseconds.
+    /// </summary>
+    double GetBuildMilliseconds () const;
+
+    /// <summary>
+    /// Returns the programs in manifest order.
+    /// </summary>
+    const std::vector<std::unique_ptr<ShaderProgram>>& GetPrograms () const;
+};
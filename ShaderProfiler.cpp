@@ -0,0 +1,294 @@
+#include "ShaderProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include "GLDispatch.h"
+
+bool ShaderProfiler::enabled = false;
+bool ShaderProfiler::timerQueries = false;
+std::chrono::steady_clock::time_point ShaderProfiler::epoch = std::chrono::steady_clock::now ();
+std::unordered_map<std::string, ShaderProfiler::ProgramProfile> ShaderProfiler::profiles;
+std::vector<ShaderProfiler::TraceEvent> ShaderProfiler::events;
+std::uint64_t ShaderProfiler::droppedEvents = 0;
+ShaderProfiler::PendingRange ShaderProfiler::openRange = {};
+std::deque<ShaderProfiler::PendingRange> ShaderProfiler::pendingRanges;
+std::vector<GLuint> ShaderProfiler::freeQueries;
+double ShaderProfiler::gpuTrackEnd = 0.0;
+
+//Compile and link timings are bounded by the number of programs, but a GPU range is recorded per bind
+static const size_t maxTraceEvents = 1 << 18;
+
+static const char* UniformTypeName (GLenum type)
+{
+    switch (type)
+    {
+    case GL_FLOAT: return "float";
+    case GL_FLOAT_VEC2: return "vec2";
+    case GL_FLOAT_VEC3: return "vec3";
+    case GL_FLOAT_VEC4: return "vec4";
+    case GL_INT: return "int";
+    case GL_INT_VEC2: return "ivec2";
+    case GL_INT_VEC3: return "ivec3";
+    case GL_INT_VEC4: return "ivec4";
+    case GL_UNSIGNED_INT: return "uint";
+    case GL_UNSIGNED_INT_VEC2: return "uvec2";
+    case GL_UNSIGNED_INT_VEC3: return "uvec3";
+    case GL_UNSIGNED_INT_VEC4: return "uvec4";
+    case GL_FLOAT_MAT2: return "mat2";
+    case GL_FLOAT_MAT2x3: return "mat2x3";
+    case GL_FLOAT_MAT2x4: return "mat2x4";
+    case GL_FLOAT_MAT3x2: return "mat3x2";
+    case GL_FLOAT_MAT3: return "mat3";
+    case GL_FLOAT_MAT3x4: return "mat3x4";
+    case GL_FLOAT_MAT4x2: return "mat4x2";
+    case GL_FLOAT_MAT4x3: return "mat4x3";
+    case GL_FLOAT_MAT4: return "mat4";
+    default: return "other";
+    }
+}
+
+static void WriteString (std::ostringstream& out, const std::string& text)
+{
+    out << '"';
+
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char> (c) < 0x20)
+            out << "\\u" << std::hex << std::setw (4) << std::setfill ('0') << static_cast<int> (c) << std::dec << std::setfill (' ');
+        else
+            out << c;
+    }
+
+    out << '"';
+}
+
+std::pair<const std::string, ShaderProfiler::ProgramProfile>& ShaderProfiler::Profile (const std::string& programName)
+{
+    //Map nodes never move, so pending ranges can point at the entry of their program
+    return *profiles.emplace (programName, ProgramProfile ()).first;
+}
+
+double ShaderProfiler::MicrosecondsSince (std::chrono::steady_clock::time_point time)
+{
+    return std::chrono::duration<double, std::micro> (time - epoch).count ();
+}
+
+void ShaderProfiler::AddEvent (TraceEvent event)
+{
+    if (events.size () >= maxTraceEvents)
+    {
+        droppedEvents++;
+        return;
+    }
+
+    events.push_back (std::move (event));
+}
+
+void ShaderProfiler::Enable (bool enable)
+{
+    if (!enable)
+        EndRange ();
+
+    enabled = enable;
+
+    if (enable)
+        timerQueries = GL ().HasTimerQueries ();
+}
+
+void ShaderProfiler::EndRange ()
+{
+    if (!openRange.program)
+        return;
+
+    GL ().EndQuery (GL_TIME_ELAPSED);
+    pendingRanges.push_back (openRange);
+    openRange = {};
+}
+
+void ShaderProfiler::Poll ()
+{
+    //Queries complete in the order they were issued, so the first unavailable result ends the scan
+    while (!pendingRanges.empty ())
+    {
+        PendingRange& range = pendingRanges.front ();
+
+        GLint available = GL_FALSE;
+        GL ().GetQueryObjectiv (range.query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (!available)
+            break;
+
+        GLuint64 nanoseconds = 0;
+        GL ().GetQueryObjectui64v (range.query, GL_QUERY_RESULT, &nanoseconds);
+
+        ProgramProfile& profile = range.program->second;
+        profile.gpuRanges++;
+        profile.gpuNanoseconds += nanoseconds;
+
+        //Ranges run back to back on the GPU, so a range cannot start before the previous one ended
+        double start = std::max (range.startMicroseconds, gpuTrackEnd);
+        double duration = nanoseconds / 1000.0;
+        gpuTrackEnd = start + duration;
+        AddEvent ({ range.program->first, "gpu", std::string (), start, duration, 1 });
+
+        freeQueries.push_back (range.query);
+        pendingRanges.pop_front ();
+    }
+}
+
+void ShaderProfiler::Reset ()
+{
+    EndRange ();
+
+    for (const PendingRange& range : pendingRanges)
+        freeQueries.push_back (range.query);
+
+    pendingRanges.clear ();
+    profiles.clear ();
+    events.clear ();
+    droppedEvents = 0;
+    gpuTrackEnd = 0.0;
+    epoch = std::chrono::steady_clock::now ();
+}
+
+const ShaderProfiler::ProgramProfile* ShaderProfiler::Find (const std::string& programName)
+{
+    auto it = profiles.find (programName);
+    return it != profiles.end () ? &it->second : nullptr;
+}
+
+const std::unordered_map<std::string, ShaderProfiler::ProgramProfile>& ShaderProfiler::GetProfiles ()
+{
+    return profiles;
+}
+
+std::string ShaderProfiler::ExportJson ()
+{
+    //Programs are written in name order so that exports can be diffed
+    std::map<std::string, const ProgramProfile*> sorted;
+
+    for (const auto& entry : profiles)
+        sorted[entry.first] = &entry.second;
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision (3);
+    out << "{\n  \"programs\": [";
+
+    bool first = true;
+
+    for (const auto& entry : sorted)
+    {
+        const ProgramProfile& profile = *entry.second;
+
+        out << (first ? "\n" : ",\n") << "    { \"name\": ";
+        WriteString (out, entry.first);
+        out << ", \"binds\": " << profile.binds << ", \"bytesUploaded\": " << profile.bytesUploaded << ", \"uniformWrites\": {";
+
+        bool firstType = true;
+
+        for (const auto& writes : profile.uniformWrites)
+        {
+            out << (firstType ? " " : ", ") << '"' << UniformTypeName (writes.first) << "\": " << writes.second;
+            firstType = false;
+        }
+
+        out << (firstType ? "}" : " }");
+        out << ", \"gpuRanges\": " << profile.gpuRanges << ", \"gpuMilliseconds\": " << profile.gpuNanoseconds / 1e6;
+        out << ", \"compileMilliseconds\": " << profile.compileMilliseconds << ", \"linkMilliseconds\": " << profile.linkMilliseconds << " }";
+        first = false;
+    }
+
+    out << (first ? "],\n" : "\n  ],\n") << "  \"timings\": [";
+    first = true;
+
+    for (const TraceEvent& event : events)
+    {
+        if (event.track != 0)
+            continue;
+
+        out << (first ? "\n" : ",\n") << "    { \"program\": ";
+        WriteString (out, event.name);
+        out << ", \"phase\": \"" << event.category << "\", \"file\": ";
+        WriteString (out, event.detail);
+        out << ", \"startMilliseconds\": " << event.startMicroseconds / 1000.0 << ", \"milliseconds\": " << event.durationMicroseconds / 1000.0 << " }";
+        first = false;
+    }
+
+    out << (first ? "],\n" : "\n  ],\n") << "  \"droppedEvents\": " << droppedEvents << "\n}\n";
+    return out.str ();
+}
+
+std::string ShaderProfiler::ExportChromeTrace ()
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision (3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+    for (const TraceEvent& event : events)
+    {
+        out << ",\n{\"name\":";
+        WriteString (out, event.detail.empty () ? event.name : event.name + " " + event.detail);
+        out << ",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.track;
+        out << ",\"ts\":" << event.startMicroseconds << ",\"dur\":" << event.durationMicroseconds << ",\"args\":{\"program\":";
+        WriteString (out, event.name);
+        out << "}}";
+    }
+
+    out << "\n]}\n";
+    return out.str ();
+}
+
+void ShaderProfiler::RecordBind (const std::string& programName)
+{
+    std::pair<const std::string, ProgramProfile>& program = Profile (programName);
+    program.second.binds++;
+
+    if (!timerQueries)
+        return;
+
+    //Time elapsed queries cannot overlap, so the range of the previous program ends where this one begins
+    EndRange ();
+
+    if (freeQueries.empty ())
+    {
+        GLuint query;
+        GL ().GenQueries (1, &query);
+        freeQueries.push_back (query);
+    }
+
+    openRange.query = freeQueries.back ();
+    openRange.program = &program;
+    openRange.startMicroseconds = MicrosecondsSince (std::chrono::steady_clock::now ());
+    freeQueries.pop_back ();
+
+    GL ().BeginQuery (GL_TIME_ELAPSED, openRange.query);
+}
+
+void ShaderProfiler::RecordUniformWrite (const std::string& programName, GLenum type, size_t bytes)
+{
+    ProgramProfile& profile = Profile (programName).second;
+    profile.uniformWrites[type]++;
+    profile.bytesUploaded += bytes;
+}
+
+void ShaderProfiler::RecordTiming (const std::string& programName, const char* phase, const std::string& detail, std::chrono::steady_clock::time_point start)
+{
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+    double milliseconds = std::chrono::duration<double, std::milli> (end - start).count ();
+
+    ProgramProfile& profile = Profile (programName).second;
+
+    if (std::strcmp (phase, "compile") == 0)
+        profile.compileMilliseconds += milliseconds;
+    else
+        profile.linkMilliseconds += milliseconds;
+
+    AddEvent ({ programName, phase, detail, MicrosecondsSince (start), milliseconds * 1000.0, 0 });
+}
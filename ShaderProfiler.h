@@ -0,0 +1,150 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+/// <summary>
+/// Opt-in instrumentation of shader programs: GPU time spent while each program is bound, UseProgram binds, uniform writes
+/// by type, bytes uploaded, and the wall time of compiling and linking each program. Disabled by default, in which case
+/// ShaderProgram pays a single branch per bind and per uniform write. Use from the GL thread only.
+/// </summary>
+class ShaderProfiler
+{
+public:
+    /// <summary>
+    /// Everything measured for one program, keyed by program name so that the numbers survive hot reloads.
+    /// </summary>
+    struct ProgramProfile
+    {
+        // UseProgram calls that reached glUseProgram
+        std::uint64_t binds;
+        // Uniform writes that reached GL, by the GLSL type written
+        std::map<GLenum, std::uint64_t> uniformWrites;
+        std::uint64_t bytesUploaded;
+        // Timer query ranges collected so far and the GPU time they add up to
+        std::uint64_t gpuRanges;
+        std::uint64_t gpuNanoseconds;
+        double compileMilliseconds;
+        double linkMilliseconds;
+    };
+
+private:
+    // One completed measurement for the Chrome trace; track 0 is the CPU, track 1 the GPU
+    struct TraceEvent
+    {
+        std::string name;
+        const char* category;
+        std::string detail;
+        double startMicroseconds;
+        double durationMicroseconds;
+        int track;
+    };
+
+    // A GL_TIME_ELAPSED query that has ended but whose result may not be available yet
+    struct PendingRange
+    {
+        GLuint query;
+        std::pair<const std::string, ProgramProfile>* program;
+        double startMicroseconds;
+    };
+
+    static bool enabled;
+    static bool timerQueries;
+    static std::chrono::steady_clock::time_point epoch;
+    static std::unordered_map<std::string, ProgramProfile> profiles;
+    static std::vector<TraceEvent> events;
+    static std::uint64_t droppedEvents;
+
+    // The range of the program bound last, if one is open
+    static PendingRange openRange;
+    static std::deque<PendingRange> pendingRanges;
+    static std::vector<GLuint> freeQueries;
+    static double gpuTrackEnd;
+
+    static std::pair<const std::string, ProgramProfile>& Profile (const std::string& programName);
+    static double MicrosecondsSince (std::chrono::steady_clock::time_point time);
+    static void AddEvent (TraceEvent event);
+
+public:
+    /// <summary>
+    /// Turns instrumentation on or off. Timer queries are used when GL 3.3 or ARB_timer_query is available; otherwise only
+    /// the CPU-side counters are kept. Turning it off ends the open timer range; measurements so far are kept.
+    /// </summary>
+    static void Enable (bool enable);
+
+    /// <summary>
+    /// Returns whether instrumentation is on.
+    /// </summary>
+    static bool IsEnabled ()
+    {
+        return enabled;
+    }
+
+    /// <summary>
+    /// Ends the timer range of the program bound last, so that work issued afterwards is not charged to it.
+    /// Call this before presenting a frame or before drawing without a program. The next UseProgram opens a new range.
+    /// </summary>
+    static void EndRange ();
+
+    /// <summary>
+    /// Collects the results of every timer range the GPU has finished, without waiting for the others.
+    /// Call this once per frame; results arrive a frame or two after the work was issued.
+    /// </summary>
+    static void Poll ();
+
+    /// <summary>
+    /// Discards every measurement and every pending timer range.
+    /// </summary>
+    static void Reset ();
+
+    /// <summary>
+    /// Returns the measurements of a program, or null if nothing has been recorded for it.
+    /// </summary>
+    static const ProgramProfile* Find (const std::string& programName);
+
+    /// <summary>
+    /// Returns the measurements of every program, keyed by program name.
+    /// </summary>
+    static const std::unordered_map<std::string, ProgramProfile>& GetProfiles ();
+
+    /// <summary>
+    /// Returns the measurements as a JSON document: one object per program with its counters and times, followed by the
+    /// individual compile and link timings.
+    /// </summary>
+    static std::string ExportJson ();
+
+    /// <summary>
+    /// Returns the compile and link timings and the GPU ranges in the Chrome trace event format, for chrome://tracing or Perfetto.
+    /// GPU ranges are placed at the time they were issued, on their own track.
+    /// </summary>
+    static std::string ExportChromeTrace ();
+
+    /// <summary>
+    /// Called by ShaderProgram when a program is bound: counts the bind and opens a timer range for the program.
+    /// </summary>
+    static void RecordBind (const std::string& programName);
+
+    /// <summary>
+    /// Called by ShaderProgram when a uniform write reaches GL.
+    /// </summary>
+    /// <param name="programName">The program written to.</param>
+    /// <param name="type">The GLSL type written.</param>
+    /// <param name="bytes">The number of bytes passed to GL.</param>
+    static void RecordUniformWrite (const std::string& programName, GLenum type, size_t bytes);
+
+    /// <summary>
+    /// Called by ShaderProgram after compiling a stage, linking, or waiting for the link to complete.
+    /// </summary>
+    /// <param name="programName">The program being built.</param>
+    /// <param name="phase">"compile", "link" or "link status".</param>
+    /// <param name="detail">The stage filename for compiles, otherwise empty.</param>
+    /// <param name="start">When the phase started.</param>
+    static void RecordTiming (const std::string& programName, const char* phase, const std::string& detail, std::chrono::steady_clock::time_point start);
+};
@@ -1,248 +1,1351 @@
 #include "ShaderProgram.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <utility>
 
 #include <glm/gtc/type_ptr.hpp>
 
-void ShaderProgram::LoadSource (GLuint shaderID, const std::string& filename) const
+#include "GLDispatch.h"
+#include "ProgramPipeline.h"
+#include "ShaderBundle.h"
+#include "ShaderSource.h"
+#include "ShaderWatcher.h"
+#include "SourceFile.h"
+#include "SourceHash.h"
+#include "StorageBuffer.h"
+#include "UniformBuffer.h"
+
+thread_local GLuint ShaderProgram::boundProgramID = 0;
+thread_local ShaderProgram::BindStats ShaderProgram::bindStats = {};
+std::string ShaderProgram::binaryCacheDirectory;
+std::unordered_map<std::string, std::vector<ShaderProgram*>> ShaderProgram::dependentPrograms;
+thread_local bool ShaderProgram::parallelCompileEnabled = false;
+thread_local ShaderProgram::UniformWriteMode ShaderProgram::uniformWriteMode = ShaderProgram::UniformWriteMode::Bound;
+ShaderWatcher* ShaderProgram::watcher = nullptr;
+std::uint64_t ShaderProgram::sourceFilesVersion = 0;
+
+std::shared_ptr<ShaderStage> ShaderProgram::AcquireStage (GLenum type, const ShaderSource& source) const
 {
-    std::ifstream stream (filename);
+    std::uint64_t sourceHash = source.Hash (HashBytes (&type, sizeof (type)));
+    std::shared_ptr<ShaderStage> stage = ShaderStage::Find (type, sourceHash);
+
+    if (stage)
+        return stage;
+
+    stage = ShaderStage::Create (type, sourceHash);
+    LoadSource (stage->GetShaderID (), source);
+    CompileSource (stage->GetShaderID (), source.GetFiles ().front ());
+
+    return stage;
+}
+
+void ShaderProgram::LoadSource (GLuint shaderID, const ShaderSource& source) const
+{
+    //The file and its includes go in as separate strings pointing into the shared fragment cache, so nothing is concatenated
+    GL ().ShaderSource (shaderID, source.GetStringCount (), source.GetStrings (), source.GetLengths ());
+}
+
+void ShaderProgram::RegisterSourceFiles (const std::vector<const ShaderSource*>& sources)
+{
+    for (const ShaderSource* source : sources)
+    {
+        if (!source)
+            continue;
+
+        for (const std::string& file : source->GetFiles ())
+        {
+            if (std::find (sourceFiles.begin (), sourceFiles.end (), file) != sourceFiles.end ())
+                continue;
+
+            sourceFiles.push_back (file);
+            dependentPrograms[file].push_back (this);
+            sourceFilesVersion++;
+        }
+    }
+}
+
+void ShaderProgram::UnregisterSourceFiles ()
+{
+    for (const std::string& file : sourceFiles)
+    {
+        std::vector<ShaderProgram*>& programs = dependentPrograms[file];
+        programs.erase (std::remove (programs.begin (), programs.end (), this), programs.end ());
+
+        if (programs.empty ())
+            dependentPrograms.erase (file);
+    }
+
+    sourceFiles.clear ();
+}
+
+void ShaderProgram::CompileSource (GLuint shaderID, const std::string& filename) const
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
+    //The status is collected later in CheckCompileStatus, so the driver is free to compile in the background
+    GL ().CompileShader (shaderID);
+
+    if (ShaderProfiler::IsEnabled ())
+        ShaderProfiler::RecordTiming (programName, "compile", filename, start);
+}
+
+/// <summary>
+/// Reads a SPIR-V module. Returns false, after reporting why, if the file cannot be read or is not a SPIR-V module.
+/// </summary>
+static bool LoadSpirvModule (const std::string& filename, std::vector<std::uint32_t>& words)
+{
+    const std::shared_ptr<const ShaderBundle>& bundle = ShaderBundle::GetMounted ();
+    std::unique_ptr<SourceFile> file;
+    const char* data;
+    size_t size;
+
+    if (!bundle || !bundle->Find (ShaderBundle::EntryKind::File, filename, data, size))
+    {
+        file.reset (new SourceFile (filename));
+
+        if (!file->IsOpen ())
+        {
+            std::cerr << "Could not open SPIR-V module: " << filename << "\n";
+            return false;
+        }
+
+        data = file->GetData ();
+        size = file->GetSize ();
+    }
+
+    words.resize (size / sizeof (std::uint32_t));
+    std::memcpy (words.data (), data, words.size () * sizeof (std::uint32_t));
+
+    //A module is a stream of words starting with the magic number, written in the byte order of the host
+    if (size % sizeof (std::uint32_t) != 0 || words.size () < 5 || words[0] != 0x07230203)
+    {
+        std::cerr << "Not a SPIR-V module: " << filename << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+/// <summary>
+/// Returns the constant_ids of the specialization constants declared by a SPIR-V module.
+/// </summary>
+static std::vector<GLuint> SpirvSpecializationIDs (const std::vector<std::uint32_t>& words)
+{
+    const std::uint32_t opDecorate = 71;
+    const std::uint32_t decorationSpecId = 1;
+    std::vector<GLuint> ids;
+
+    //Instructions follow the five-word header; each starts with its word count in the high half and its opcode in the low half
+    for (size_t i = 5; i < words.size ();)
+    {
+        std::uint32_t wordCount = words[i] >> 16;
+        std::uint32_t opcode = words[i] & 0xFFFF;
+
+        if (wordCount == 0 || i + wordCount > words.size ())
+            break;
+
+        if (opcode == opDecorate && wordCount >= 4 && words[i + 2] == decorationSpecId)
+            ids.push_back (words[i + 3]);
+
+        i += wordCount;
+    }
+
+    return ids;
+}
+
+std::shared_ptr<ShaderStage> ShaderProgram::AcquireSpirvStage (GLenum type, const std::string& filename, const std::vector<SpecializationConstant>& constants) const
+{
+    std::vector<std::uint32_t> words;
+
+    if (!LoadSpirvModule (filename, words))
+        return nullptr;
+
+    //Specializing with a constant the module does not declare fails, so each module gets only its own constants
+    std::vector<GLuint> declared = SpirvSpecializationIDs (words);
+    std::vector<GLuint> indices;
+    std::vector<GLuint> values;
+
+    for (const SpecializationConstant& constant : constants)
+    {
+        if (std::find (declared.begin (), declared.end (), constant.id) != declared.end ())
+        {
+            indices.push_back (constant.id);
+            values.push_back (constant.value);
+        }
+    }
+
+    //Keyed apart from GLSL stages, since a module and a source file could hash alike
+    std::uint64_t key = HashString ("spirv", HashBytes (&type, sizeof (type)));
+    key = HashBytes (words.data (), words.size () * sizeof (std::uint32_t), key);
+    key = HashBytes (indices.data (), indices.size () * sizeof (GLuint), key);
+    key = HashBytes (values.data (), values.size () * sizeof (GLuint), key);
+
+    std::shared_ptr<ShaderStage> stage = ShaderStage::Find (type, key);
+
+    if (stage)
+        return stage;
+
+    stage = ShaderStage::Create (type, key);
+    GLuint shaderID = stage->GetShaderID ();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
+    GL ().ShaderBinary (1, &shaderID, GL_SHADER_BINARY_FORMAT_SPIR_V, words.data (), static_cast<GLsizei> (words.size () * sizeof (std::uint32_t)));
+
+    //Specialization is where the driver compiles the module; the status is collected in CheckCompileStatus like a GLSL stage's
+    if (GL ().HasCoreSpirv ())
+        GL ().SpecializeShader (shaderID, "main", static_cast<GLuint> (indices.size ()), indices.data (), values.data ());
+    else
+        GL ().SpecializeShaderARB (shaderID, "main", static_cast<GLuint> (indices.size ()), indices.data (), values.data ());
+
+    if (ShaderProfiler::IsEnabled ())
+        ShaderProfiler::RecordTiming (programName, "compile", filename, start);
+
+    return stage;
+}
+
+bool ShaderProgram::CheckCompileStatus (GLuint shaderID, const std::string& filename) const
+{
+    int success;
+    GL ().GetShaderiv (shaderID, GL_COMPILE_STATUS, &success);
+
+    if (!success)
+    {
+        GLint logLength;
+        GL ().GetShaderiv (shaderID, GL_INFO_LOG_LENGTH, &logLength);
+        GLchar* log = new GLchar[logLength];
+        GL ().GetShaderInfoLog (shaderID, logLength, NULL, log);
+        std::cerr << "Error compiling shader: " << filename << "\n" << log << "\n";
+        delete[] log;
+        return false;
+    }
+
+    return true;
+}
+
+void ShaderProgram::LinkProgram () const
+{
+    for (const std::shared_ptr<ShaderStage>* stage : { &vertexStage, &geometryStage, &fragmentStage, &computeStage })
+    {
+        if (*stage)
+            GL ().AttachShader (programID, (*stage)->GetShaderID ());
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+    GL ().LinkProgram (programID);
+
+    if (ShaderProfiler::IsEnabled ())
+        ShaderProfiler::RecordTiming (programName, "link", std::string (), start);
+}
+
+bool ShaderProgram::CheckLinkStatus ()
+{
+    if (loadedFromBinaryCache)
+        return true;
+
+    //Most of the time spent here is waiting for the driver to finish compiling and linking
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+    bool compiled = true;
+
+    if (vertexStage)
+        compiled = CheckCompileStatus (vertexStage->GetShaderID (), vertexFilename) && compiled;
+
+    if (geometryStage)
+        compiled = CheckCompileStatus (geometryStage->GetShaderID (), geometryFilename) && compiled;
+
+    if (fragmentStage)
+        compiled = CheckCompileStatus (fragmentStage->GetShaderID (), fragmentFilename) && compiled;
+
+    if (computeStage)
+        compiled = CheckCompileStatus (computeStage->GetShaderID (), computeFilename) && compiled;
+
+    for (const std::shared_ptr<ShaderStage>* stage : { &vertexStage, &geometryStage, &fragmentStage, &computeStage })
+    {
+        if (*stage)
+            GL ().DetachShader (programID, (*stage)->GetShaderID ());
+    }
+
+    //While a watcher may reload the program, its stages stay alive so unchanged stages are not compiled again
+    if (!watcher)
+        ReleaseStages ();
+
+    if (!compiled)
+        return false;
+
+    GLint success;
+    GL ().GetProgramiv (programID, GL_LINK_STATUS, &success);
+
+    if (ShaderProfiler::IsEnabled ())
+        ShaderProfiler::RecordTiming (programName, "link status", std::string (), start);
+
+    if (!success)
+    {
+        GLint logLength;
+        GL ().GetProgramiv (programID, GL_INFO_LOG_LENGTH, &logLength);
+        GLchar* log = new GLchar[logLength];
+        GL ().GetProgramInfoLog (programID, logLength, NULL, log);
+        std::cerr << "Error linking shader: " << programName << "\n" << log << "\n";
+        delete[] log;
+        return false;
+    }
+
+    //Stored before reflection binds blocks by name, so a cached binary only carries the bindings declared in the shader
+    StoreCachedBinary ();
+    ReflectUniforms ();
+
+    return true;
+}
+
+void ShaderProgram::ReleaseStages ()
+{
+    //A stage is deleted once the last program holding it lets go; GL defers the deletion while it is still attached
+    vertexStage.reset ();
+    geometryStage.reset ();
+    fragmentStage.reset ();
+    computeStage.reset ();
+}
+
+bool ShaderProgram::IsLinkComplete () const
+{
+    if (loadedFromBinaryCache || !SupportsParallelCompile ())
+        return true;
+
+    GLint complete;
+    GL ().GetProgramiv (programID, GL_COMPLETION_STATUS_KHR, &complete);
+
+    return complete == GL_TRUE;
+}
+
+bool ShaderProgram::SupportsParallelCompile ()
+{
+    return GL ().HasParallelCompile ();
+}
+
+void ShaderProgram::EnableParallelCompile ()
+{
+    if (parallelCompileEnabled || !SupportsParallelCompile ())
+        return;
+
+    //Let the driver pick how many compiler threads to use
+    if (GL ().HasKHRParallelCompile ())
+        GL ().MaxShaderCompilerThreadsKHR (0xFFFFFFFF);
+    else
+        GL ().MaxShaderCompilerThreadsARB (0xFFFFFFFF);
+
+    parallelCompileEnabled = true;
+}
+
+void ShaderProgram::ReflectUniforms ()
+{
+    uniforms.clear ();
+
+    GLint uniformCount;
+    GL ().GetProgramiv (programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+    GLint maxNameLength;
+    GL ().GetProgramiv (programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<GLchar> nameBuffer (std::max (maxNameLength, 1));
+    uniforms.reserve (uniformCount);
+
+    for (GLint i = 0; i < uniformCount; i++)
+    {
+        GLsizei nameLength;
+        GLint size;
+        GLenum type;
+        GL ().GetActiveUniform (programID, i, nameBuffer.size (), &nameLength, &size, &type, nameBuffer.data ());
+
+        GLint location;
+
+        //SPIR-V uniforms need not have names, so their locations are read from the resource rather than looked up by name
+        if (spirv)
+        {
+            const GLenum property = GL_LOCATION;
+            GL ().GetProgramResourceiv (programID, GL_UNIFORM, i, 1, &property, 1, nullptr, &location);
+        }
+        else
+            location = GL ().GetUniformLocation (programID, nameBuffer.data ());
+
+        //Uniforms inside uniform blocks have no location
+        if (location == -1)
+            continue;
+
+        std::string name (nameBuffer.data (), nameLength);
+
+        //Unnamed uniforms are stored under their location, written "#location", which no GLSL name can collide with
+        if (name.empty ())
+            name = "#" + std::to_string (location);
+
+        //Arrays are reported as name[0]; store them under the name they are usually set by
+        if (name.size () > 3 && name.compare (name.size () - 3, 3, "[0]") == 0)
+            name.resize (name.size () - 3);
+
+        uniforms.push_back ({ std::move (name), location, type, size });
+    }
+
+    std::sort (uniforms.begin (), uniforms.end (), [] (const UniformInfo& a, const UniformInfo& b) { return a.name < b.name; });
+
+    shadows.clear ();
+    shadows.reserve (uniforms.size ());
+    elementLocations.clear ();
+    size_t shadowSize = 0;
+
+    for (const UniformInfo& uniform : uniforms)
+    {
+        GLsizei elementSize = UniformTypeSize (uniform.type);
+        bool contiguous = true;
+
+        //SPIR-V arrays take consecutive explicit locations
+        if (uniform.size > 1 && !spirv)
+        {
+            std::string lastElement = uniform.name + "[" + std::to_string (uniform.size - 1) + "]";
+            contiguous = GL ().GetUniformLocation (programID, lastElement.c_str ()) == uniform.location + uniform.size - 1;
+        }
+
+        //Element locations of other arrays are looked up the first time each element is written on its own
+        size_t locationsOffset = elementLocations.size ();
+
+        if (!contiguous)
+        {
+            elementLocations.resize (locationsOffset + uniform.size, UnresolvedLocation);
+            elementLocations[locationsOffset] = uniform.location;
+        }
+
+        shadows.push_back ({ shadowSize, elementSize, 0, contiguous, locationsOffset });
+        shadowSize += static_cast<size_t> (elementSize) * uniform.size;
+    }
+
+    shadowValues.assign (shadowSize, 0);
+
+    ReflectUniformBlocks ();
+    ReflectStorageBlocks ();
+
+    if (!computeFilename.empty ())
+        GL ().GetProgramiv (programID, GL_COMPUTE_WORK_GROUP_SIZE, workGroupSize);
+}
+
+void ShaderProgram::ReflectUniformBlocks ()
+{
+    uniformBlocks.clear ();
+
+    GLint blockCount;
+    GL ().GetProgramiv (programID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    GLint maxBlockNameLength;
+    GL ().GetProgramiv (programID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+    GLint maxNameLength;
+    GL ().GetProgramiv (programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<GLchar> nameBuffer (std::max ({ maxBlockNameLength, maxNameLength, 1 }));
+    uniformBlocks.reserve (blockCount);
+
+    for (GLint i = 0; i < blockCount; i++)
+    {
+        BlockInfo block;
+        block.index = i;
+
+        GLsizei nameLength;
+        GL ().GetActiveUniformBlockName (programID, i, nameBuffer.size (), &nameLength, nameBuffer.data ());
+        block.name.assign (nameBuffer.data (), nameLength);
+
+        GL ().GetActiveUniformBlockiv (programID, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.dataSize);
+
+        GLint memberCount;
+        GL ().GetActiveUniformBlockiv (programID, i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+
+        if (memberCount > 0)
+        {
+            std::vector<GLint> memberIndices (memberCount);
+            GL ().GetActiveUniformBlockiv (programID, i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, memberIndices.data ());
+
+            const GLuint* indices = reinterpret_cast<const GLuint*> (memberIndices.data ());
+            std::vector<GLint> types (memberCount), sizes (memberCount), offsets (memberCount), arrayStrides (memberCount), matrixStrides (memberCount);
+            GL ().GetActiveUniformsiv (programID, memberCount, indices, GL_UNIFORM_TYPE, types.data ());
+            GL ().GetActiveUniformsiv (programID, memberCount, indices, GL_UNIFORM_SIZE, sizes.data ());
+            GL ().GetActiveUniformsiv (programID, memberCount, indices, GL_UNIFORM_OFFSET, offsets.data ());
+            GL ().GetActiveUniformsiv (programID, memberCount, indices, GL_UNIFORM_ARRAY_STRIDE, arrayStrides.data ());
+            GL ().GetActiveUniformsiv (programID, memberCount, indices, GL_UNIFORM_MATRIX_STRIDE, matrixStrides.data ());
+
+            block.members.reserve (memberCount);
+
+            for (GLint j = 0; j < memberCount; j++)
+            {
+                GL ().GetActiveUniformName (programID, indices[j], nameBuffer.size (), &nameLength, nameBuffer.data ());
+                std::string name (nameBuffer.data (), nameLength);
+
+                if (name.size () > 3 && name.compare (name.size () - 3, 3, "[0]") == 0)
+                    name.resize (name.size () - 3);
+
+                block.members.push_back ({ std::move (name), static_cast<GLenum> (types[j]), sizes[j], offsets[j], arrayStrides[j], matrixStrides[j] });
+            }
+
+            std::sort (block.members.begin (), block.members.end (), [] (const BlockMemberInfo& a, const BlockMemberInfo& b) { return a.offset < b.offset; });
+        }
+
+        //Blocks are bound by name, so any program declaring a block reads the same buffer. A binding declared in the shader is
+        //kept, as are all bindings of SPIR-V programs, whose blocks need not have names; layout (binding = 0) cannot be told
+        //apart from no binding, so such blocks are bound by name too
+        GLint declaredBinding;
+        GL ().GetActiveUniformBlockiv (programID, i, GL_UNIFORM_BLOCK_BINDING, &declaredBinding);
+
+        if (spirv || declaredBinding != 0)
+        {
+            block.binding = declaredBinding;
+
+            if (!block.name.empty ())
+                UniformBuffer::ReserveBindingPoint (block.name, block.binding);
+        }
+        else
+        {
+            block.binding = UniformBuffer::GetBindingPoint (block.name);
+            GL ().UniformBlockBinding (programID, block.index, block.binding);
+        }
+
+        uniformBlocks.push_back (std::move (block));
+    }
+
+    std::sort (uniformBlocks.begin (), uniformBlocks.end (), [] (const BlockInfo& a, const BlockInfo& b) { return a.name < b.name; });
+}
+
+void ShaderProgram::ReflectStorageBlocks ()
+{
+    storageBlocks.clear ();
+
+    if (!GL ().HasStorageBlocks ())
+        return;
+
+    GLint blockCount;
+    GL ().GetProgramInterfaceiv (programID, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &blockCount);
+    GLint maxBlockNameLength;
+    GL ().GetProgramInterfaceiv (programID, GL_SHADER_STORAGE_BLOCK, GL_MAX_NAME_LENGTH, &maxBlockNameLength);
+    GLint maxNameLength;
+    GL ().GetProgramInterfaceiv (programID, GL_BUFFER_VARIABLE, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+    std::vector<GLchar> nameBuffer (std::max ({ maxBlockNameLength, maxNameLength, 1 }));
+    storageBlocks.reserve (blockCount);
+
+    const GLenum blockProperties[] = { GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES, GL_BUFFER_BINDING };
+    const GLenum memberProperties[] = { GL_TYPE, GL_ARRAY_SIZE, GL_OFFSET, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE };
+
+    for (GLint i = 0; i < blockCount; i++)
+    {
+        BlockInfo block;
+        block.index = i;
+
+        GLsizei nameLength;
+        GL ().GetProgramResourceName (programID, GL_SHADER_STORAGE_BLOCK, i, nameBuffer.size (), &nameLength, nameBuffer.data ());
+        block.name.assign (nameBuffer.data (), nameLength);
+
+        GLint blockValues[3];
+        GL ().GetProgramResourceiv (programID, GL_SHADER_STORAGE_BLOCK, i, 3, blockProperties, 3, NULL, blockValues);
+        block.dataSize = blockValues[0];
+
+        if (blockValues[1] > 0)
+        {
+            std::vector<GLint> memberIndices (blockValues[1]);
+            const GLenum activeVariables = GL_ACTIVE_VARIABLES;
+            GL ().GetProgramResourceiv (programID, GL_SHADER_STORAGE_BLOCK, i, 1, &activeVariables, blockValues[1], NULL, memberIndices.data ());
+
+            block.members.reserve (blockValues[1]);
+
+            for (GLint memberIndex : memberIndices)
+            {
+                GLint memberValues[5];
+                GL ().GetProgramResourceiv (programID, GL_BUFFER_VARIABLE, memberIndex, 5, memberProperties, 5, NULL, memberValues);
+                GL ().GetProgramResourceName (programID, GL_BUFFER_VARIABLE, memberIndex, nameBuffer.size (), &nameLength, nameBuffer.data ());
+                std::string name (nameBuffer.data (), nameLength);
+
+                if (name.size () > 3 && name.compare (name.size () - 3, 3, "[0]") == 0)
+                    name.resize (name.size () - 3);
+
+                block.members.push_back ({ std::move (name), static_cast<GLenum> (memberValues[0]), memberValues[1], memberValues[2], memberValues[3], memberValues[4] });
+            }
+
+            std::sort (block.members.begin (), block.members.end (), [] (const BlockMemberInfo& a, const BlockMemberInfo& b) { return a.offset < b.offset; });
+        }
+
+        //Declared bindings are kept as for uniform blocks
+        if (spirv || blockValues[2] != 0)
+        {
+            block.binding = blockValues[2];
+
+            if (!block.name.empty ())
+                ReserveStorageBindingPoint (block.name, block.binding);
+        }
+        else
+        {
+            block.binding = GetStorageBindingPoint (block.name);
+            GL ().ShaderStorageBlockBinding (programID, block.index, block.binding);
+        }
+
+        storageBlocks.push_back (std::move (block));
+    }
+
+    std::sort (storageBlocks.begin (), storageBlocks.end (), [] (const BlockInfo& a, const BlockInfo& b) { return a.name < b.name; });
+}
+
+bool ShaderProgram::LoadCachedBinary (const std::vector<const ShaderSource*>& sources)
+{
+    const std::shared_ptr<const ShaderBundle>& bundle = ShaderBundle::GetMounted ();
+
+    if (binaryCacheDirectory.empty () && !bundle)
+        return false;
+
+    GLint formatCount;
+    GL ().GetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+    if (formatCount == 0)
+        return false;
+
+    //The key covers every resolved stage source and the driver, so edits, include edits and driver updates all miss
+    std::uint64_t key = SourceHashSeed;
+
+    for (const ShaderSource* source : sources)
+        key = source ? source->Hash (key) : HashText ("", 0, key);
+
+    //A separable program links differently from a monolithic one built from the same source
+    if (separable)
+        key = HashBytes (&singleStageType, sizeof (singleStageType), key);
+
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        key = HashString (reinterpret_cast<const char*> (GL ().GetString (name)), key);
+
+    char keyText[17];
+    std::snprintf (keyText, sizeof (keyText), "%016llx", static_cast<unsigned long long> (key));
+    GLenum format;
+    std::uint32_t length;
+    const char* packedBinary;
+    size_t packedSize;
+
+    //Binaries packed into the mounted bundle are handed to GL straight out of the mapping; a rejected one falls back to the cache directory
+    if (bundle && bundle->Find (ShaderBundle::EntryKind::Binary, keyText, packedBinary, packedSize) && packedSize >= sizeof (format) + sizeof (length))
+    {
+        std::memcpy (&format, packedBinary, sizeof (format));
+        std::memcpy (&length, packedBinary + sizeof (format), sizeof (length));
+
+        if (length == packedSize - (sizeof (format) + sizeof (length)))
+        {
+            GL ().ProgramBinary (programID, format, packedBinary + sizeof (format) + sizeof (length), length);
+
+            if (CheckCachedBinaryLink ())
+                return true;
+        }
+    }
+
+    if (binaryCacheDirectory.empty ())
+        return false;
+
+    binaryCachePath = binaryCacheDirectory + "/" + keyText + ".bin";
+
+    //Must be set before linking for the binary to be retrievable on a miss
+    GL ().ProgramParameteri (programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    std::ifstream stream (binaryCachePath, std::ios::binary | std::ios::ate);
 
     if (!stream.is_open ())
+        return false;
+
+    std::streamoff fileSize = stream.tellg ();
+    stream.seekg (0);
+
+    stream.read (reinterpret_cast<char*> (&format), sizeof (format));
+    stream.read (reinterpret_cast<char*> (&length), sizeof (length));
+
+    if (!stream || length != fileSize - static_cast<std::streamoff> (sizeof (format) + sizeof (length)))
+        return false;
+
+    std::vector<char> binary (length);
+    stream.read (binary.data (), length);
+
+    if (!stream)
+        return false;
+
+    GL ().ProgramBinary (programID, format, binary.data (), length);
+    return CheckCachedBinaryLink ();
+}
+
+bool ShaderProgram::CheckCachedBinaryLink ()
+{
+    GLint success;
+    GL ().GetProgramiv (programID, GL_LINK_STATUS, &success);
+
+    //A stale or rejected binary leaves the program unlinked, and the caller builds it from source instead
+    if (!success)
+        return false;
+
+    loadedFromBinaryCache = true;
+    ReflectUniforms ();
+
+    return true;
+}
+
+void ShaderProgram::StoreCachedBinary () const
+{
+    if (binaryCachePath.empty ())
+        return;
+
+    GLint length;
+    GL ().GetProgramiv (programID, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary (length);
+    GLenum format;
+    GL ().GetProgramBinary (programID, length, &length, &format, binary.data ());
+
+    //Write to a temporary file first so an interrupted write never leaves a truncated binary behind
+    std::string temporaryPath = binaryCachePath + ".tmp";
+
+    {
+        std::ofstream stream (temporaryPath, std::ios::binary | std::ios::trunc);
+
+        if (!stream.is_open ())
+        {
+            std::cerr << "Could not write program binary cache: " << temporaryPath << "\n";
+            return;
+        }
+
+        std::uint32_t storedLength = length;
+        stream.write (reinterpret_cast<const char*> (&format), sizeof (format));
+        stream.write (reinterpret_cast<const char*> (&storedLength), sizeof (storedLength));
+        stream.write (binary.data (), length);
+    }
+
+    std::remove (binaryCachePath.c_str ());
+    std::rename (temporaryPath.c_str (), binaryCachePath.c_str ());
+}
+
+ShaderProgram::~ShaderProgram ()
+{
+    if (watcher)
+        watcher->Forget (this);
+
+    if (separable)
+        ProgramPipeline::Forget (this);
+
+    ReleaseStages ();
+    UnregisterSourceFiles ();
+
+    //The name may be handed out again by glCreateProgram, so a new program must not look already bound
+    if (boundProgramID == programID)
+        boundProgramID = 0;
+
+    GL ().DeleteProgram (programID);
+}
+
+#pragma region Factory Constructors
+
+std::unique_ptr<ShaderProgram> ShaderProgram::SubmitStages (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename, const std::string& defines)
+{
+    std::unique_ptr<ShaderProgram> program (new ShaderProgram ());
+
+    program->programID = GL ().CreateProgram ();
+
+    program->programName = programName;
+    program->vertexFilename = vertexFilename;
+    program->geometryFilename = geometryFilename;
+    program->fragmentFilename = fragmentFilename;
+    program->defines = defines;
+
+    ShaderSource vertexSource (vertexFilename, defines);
+    std::unique_ptr<ShaderSource> geometrySource (geometryFilename.empty () ? nullptr : new ShaderSource (geometryFilename, defines));
+    ShaderSource fragmentSource (fragmentFilename, defines);
+    std::vector<const ShaderSource*> sources = { &vertexSource, geometrySource.get (), &fragmentSource };
+
+    if (!vertexSource.IsComplete () || (geometrySource && !geometrySource->IsComplete ()) || !fragmentSource.IsComplete ())
+        return nullptr;
+
+    program->RegisterSourceFiles (sources);
+
+    if (program->LoadCachedBinary (sources))
+        return program;
+
+    EnableParallelCompile ();
+
+    program->vertexStage = program->AcquireStage (GL_VERTEX_SHADER, vertexSource);
+
+    if (geometrySource)
+        program->geometryStage = program->AcquireStage (GL_GEOMETRY_SHADER, *geometrySource);
+
+    program->fragmentStage = program->AcquireStage (GL_FRAGMENT_SHADER, fragmentSource);
+
+    return program;
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::SubmitSingleStage (const std::string& programName, GLenum stageType, const std::string& filename, bool separable, const std::string& defines)
+{
+    std::unique_ptr<ShaderProgram> program (new ShaderProgram ());
+
+    program->programID = GL ().CreateProgram ();
+
+    program->programName = programName;
+    program->singleStageType = stageType;
+    program->separable = separable;
+    program->defines = defines;
+    *program->FilenameSlot (stageType) = filename;
+
+    //Must be set before linking or loading a binary for the program to be usable in a pipeline
+    if (separable)
+        GL ().ProgramParameteri (program->programID, GL_PROGRAM_SEPARABLE, GL_TRUE);
+
+    ShaderSource source (filename, defines);
+    std::vector<const ShaderSource*> sources = { &source };
+
+    if (!source.IsComplete ())
+        return nullptr;
+
+    program->RegisterSourceFiles (sources);
+
+    if (program->LoadCachedBinary (sources))
+        return program;
+
+    EnableParallelCompile ();
+
+    *program->StageSlot (stageType) = program->AcquireStage (stageType, source);
+
+    return program;
+}
+
+std::shared_ptr<ShaderStage>* ShaderProgram::StageSlot (GLenum stageType)
+{
+    switch (stageType)
+    {
+    case GL_VERTEX_SHADER:
+        return &vertexStage;
+    case GL_GEOMETRY_SHADER:
+        return &geometryStage;
+    case GL_FRAGMENT_SHADER:
+        return &fragmentStage;
+    case GL_COMPUTE_SHADER:
+        return &computeStage;
+    default:
+        std::cerr << "Unsupported shader stage type: " << stageType << "\n";
+        exit (EXIT_FAILURE);
+    }
+}
+
+std::string* ShaderProgram::FilenameSlot (GLenum stageType)
+{
+    switch (stageType)
     {
-        std::cerr << "Could not open shader file: " << filename << "\n";
+    case GL_VERTEX_SHADER:
+        return &vertexFilename;
+    case GL_GEOMETRY_SHADER:
+        return &geometryFilename;
+    case GL_FRAGMENT_SHADER:
+        return &fragmentFilename;
+    case GL_COMPUTE_SHADER:
+        return &computeFilename;
+    default:
+        std::cerr << "Unsupported shader stage type: " << stageType << "\n";
         exit (EXIT_FAILURE);
     }
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::Submit (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename, const std::string& defines)
+{
+    std::unique_ptr<ShaderProgram> program = SubmitStages (programName, vertexFilename, geometryFilename, fragmentFilename, defines);
+
+    if (!program)
+        exit (EXIT_FAILURE);
+
+    if (!program->loadedFromBinaryCache)
+        program->LinkProgram ();
+
+    return program;
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::CreateBasicShaderProgram (const std::string& programName)
+{
+    return CreateBasicShaderProgramWithNames (programName, programName + ".vert", programName + ".frag");
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::CreateBasicShaderProgramWithNames (const std::string& programName, const std::string& vertexFilename, const std::string& fragmentFilename)
+{
+    std::unique_ptr<ShaderProgram> program = Submit (programName, vertexFilename, "", fragmentFilename);
+
+    if (!program->CheckLinkStatus ())
+        exit (EXIT_FAILURE);
+
+    return program;
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::CreateShaderProgramWithGeometry (const std::string& programName)
+{
+    return CreateShaderProgramWithGeometryWithNames (programName, programName + ".vert", programName + ".geom", programName + ".frag");
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::CreateShaderProgramWithGeometryWithNames (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename)
+{
+    std::unique_ptr<ShaderProgram> program = Submit (programName, vertexFilename, geometryFilename, fragmentFilename);
+
+    if (!program->CheckLinkStatus ())
+        exit (EXIT_FAILURE);
+
+    return program;
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::CreateComputeProgram (const std::string& programName)
+{
+    return CreateComputeProgramWithName (programName, programName + ".comp");
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::CreateComputeProgramWithName (const std::string& programName, const std::string& computeFilename)
+{
+    if (!GL ().HasComputeShaders ())
+    {
+        std::cerr << "Compute shaders are not supported, cannot create shader program: " << programName << "\n";
+        exit (EXIT_FAILURE);
+    }
+
+    std::unique_ptr<ShaderProgram> program = SubmitSingleStage (programName, GL_COMPUTE_SHADER, computeFilename, false);
+
+    if (!program)
+        exit (EXIT_FAILURE);
+
+    if (!program->loadedFromBinaryCache)
+        program->LinkProgram ();
+
+    if (!program->CheckLinkStatus ())
+        exit (EXIT_FAILURE);
+
+    return program;
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::CreateSeparableProgram (const std::string& programName, GLenum stageType, const std::string& filename)
+{
+    if (!GL ().HasSeparatePrograms ())
+    {
+        std::cerr << "Separable programs are not supported, cannot create shader program: " << programName << "\n";
+        exit (EXIT_FAILURE);
+    }
+
+    std::unique_ptr<ShaderProgram> program = SubmitSingleStage (programName, stageType, filename, true);
+
+    if (!program)
+        exit (EXIT_FAILURE);
+
+    if (!program->loadedFromBinaryCache)
+        program->LinkProgram ();
+
+    if (!program->CheckLinkStatus ())
+        exit (EXIT_FAILURE);
+
+    return program;
+}
+
+#pragma endregion
+
+#pragma region SPIR-V Factory Constructors
+
+void ShaderProgram::RequireSpirv (const std::string& programName)
+{
+    if (!GL ().HasSpirv ())
+    {
+        std::cerr << "SPIR-V shaders are not supported, cannot create shader program: " << programName << "\n";
+        exit (EXIT_FAILURE);
+    }
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::SubmitSpirv (const std::string& programName, const std::vector<std::pair<GLenum, std::string>>& stages, const std::vector<SpecializationConstant>& constants)
+{
+    RequireSpirv (programName);
+
+    std::unique_ptr<ShaderProgram> program (new ShaderProgram ());
+
+    program->programID = GL ().CreateProgram ();
+    program->programName = programName;
+    program->spirv = true;
+
+    for (const std::pair<GLenum, std::string>& stage : stages)
+    {
+        *program->FilenameSlot (stage.first) = stage.second;
+        *program->StageSlot (stage.first) = program->AcquireSpirvStage (stage.first, stage.second, constants);
+
+        if (!*program->StageSlot (stage.first))
+            return nullptr;
+    }
+
+    //Modules are already compiled, so there is no source to watch and nothing for the binary cache to save
+    program->LinkProgram ();
+
+    return program;
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::CreateSpirvProgram (const std::string& programName, const std::vector<SpecializationConstant>& constants)
+{
+    return CreateSpirvProgramWithNames (programName, programName + ".vert.spv", programName + ".frag.spv", constants);
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::CreateSpirvProgramWithNames (const std::string& programName, const std::string& vertexFilename, const std::string& fragmentFilename, const std::vector<SpecializationConstant>& constants)
+{
+    std::unique_ptr<ShaderProgram> program = SubmitSpirv (programName, { { GL_VERTEX_SHADER, vertexFilename }, { GL_FRAGMENT_SHADER, fragmentFilename } }, constants);
+
+    if (!program || !program->CheckLinkStatus ())
+        exit (EXIT_FAILURE);
+
+    return program;
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::CreateSpirvProgramWithGeometryWithNames (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename, const std::vector<SpecializationConstant>& constants)
+{
+    std::unique_ptr<ShaderProgram> program = SubmitSpirv (programName, { { GL_VERTEX_SHADER, vertexFilename }, { GL_GEOMETRY_SHADER, geometryFilename }, { GL_FRAGMENT_SHADER, fragmentFilename } }, constants);
+
+    if (!program || !program->CheckLinkStatus ())
+        exit (EXIT_FAILURE);
+
+    return program;
+}
+
+std::unique_ptr<ShaderProgram> ShaderProgram::CreateSpirvComputeProgramWithName (const std::string& programName, const std::string& computeFilename, const std::vector<SpecializationConstant>& constants)
+{
+    if (!GL ().HasComputeShaders ())
+    {
+        std::cerr << "Compute shaders are not supported, cannot create shader program: " << programName << "\n";
+        exit (EXIT_FAILURE);
+    }
+
+    std::unique_ptr<ShaderProgram> program = SubmitSpirv (programName, { { GL_COMPUTE_SHADER, computeFilename } }, constants);
+
+    if (!program || !program->CheckLinkStatus ())
+        exit (EXIT_FAILURE);
+
+    return program;
+}
+
+#pragma endregion
+
+#pragma region Asynchronous Factory Constructors
+
+std::unique_ptr<PendingShaderProgram> ShaderProgram::CreateBasicShaderProgramAsync (const std::string& programName)
+{
+    return CreateBasicShaderProgramWithNamesAsync (programName, programName + ".vert", programName + ".frag");
+}
+
+std::unique_ptr<PendingShaderProgram> ShaderProgram::CreateBasicShaderProgramWithNamesAsync (const std::string& programName, const std::string& vertexFilename, const std::string& fragmentFilename)
+{
+    return std::unique_ptr<PendingShaderProgram> (new PendingShaderProgram (Submit (programName, vertexFilename, "", fragmentFilename)));
+}
+
+std::unique_ptr<PendingShaderProgram> ShaderProgram::CreateShaderProgramWithGeometryAsync (const std::string& programName)
+{
+    return CreateShaderProgramWithGeometryWithNamesAsync (programName, programName + ".vert", programName + ".geom", programName + ".frag");
+}
 
-    std::vector<std::string> lineVector;
-    std::string line;
+std::unique_ptr<PendingShaderProgram> ShaderProgram::CreateShaderProgramWithGeometryWithNamesAsync (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename)
+{
+    return std::unique_ptr<PendingShaderProgram> (new PendingShaderProgram (Submit (programName, vertexFilename, geometryFilename, fragmentFilename)));
+}
 
-    while (std::getline (stream, line))
-        lineVector.emplace_back (std::move (line));
+#pragma endregion
 
-    size_t linesCount = lineVector.size ();
-    GLchar** cLineArray = new GLchar* [linesCount];
+void ShaderProgram::AdoptProgram (ShaderProgram& rebuilt)
+{
+    //Handles resolved against the old table are carried over to the new one by name
+    std::vector<GLint> indices;
+    indices.reserve (uniforms.size ());
 
-    for (size_t i = 0; i < linesCount; i++)
+    for (const UniformInfo& uniform : uniforms)
     {
-        size_t lineLength = lineVector[i].length ();
-        //lineLength + 2 for newline and null-terminator
-        GLchar* cLine = new GLchar[lineLength + 2];
-        lineVector[i].copy (cLine, lineLength, 0);
-        cLine[lineLength] = '\n';
-        cLine[lineLength + 1] = '\0';
-        cLineArray[i] = cLine;
+        const UniformInfo* reloaded = rebuilt.FindUniform (uniform.name.c_str ());
+        indices.push_back (reloaded ? static_cast<GLint> (reloaded - rebuilt.uniforms.data ()) : -1);
     }
 
-    glShaderSource (shaderID, linesCount, cLineArray, NULL);
+    reloadedIndices.push_back (std::move (indices));
+    reportedStaleWrite = false;
+
+    //Swap the GL objects, so the rebuilt object deletes the old program when it is destroyed
+    std::swap (programID, rebuilt.programID);
+    std::swap (vertexStage, rebuilt.vertexStage);
+    std::swap (geometryStage, rebuilt.geometryStage);
+    std::swap (fragmentStage, rebuilt.fragmentStage);
+    std::swap (computeStage, rebuilt.computeStage);
+    std::swap (workGroupSize, rebuilt.workGroupSize);
+
+    //The uniform table, shadow values and cached locations must all describe the new program
+    std::swap (uniforms, rebuilt.uniforms);
+    std::swap (uniformBlocks, rebuilt.uniformBlocks);
+    std::swap (storageBlocks, rebuilt.storageBlocks);
+    std::swap (shadows, rebuilt.shadows);
+    std::swap (shadowValues, rebuilt.shadowValues);
+    std::swap (elementLocations, rebuilt.elementLocations);
+
+    std::swap (binaryCachePath, rebuilt.binaryCachePath);
+    std::swap (loadedFromBinaryCache, rebuilt.loadedFromBinaryCache);
+
+    //An include may have been added or removed
+    std::vector<std::string> files = rebuilt.sourceFiles;
+    rebuilt.UnregisterSourceFiles ();
+    UnregisterSourceFiles ();
+
+    for (const std::string& file : files)
+    {
+        sourceFiles.push_back (file);
+        dependentPrograms[file].push_back (this);
+    }
 
-    for (size_t i = 0; i < linesCount; i++)
-        delete[] cLineArray[i];
+    sourceFilesVersion++;
+    generation++;
+}
 
-    delete[] cLineArray;
+bool ShaderProgram::IsSeparable () const
+{
+    return separable;
 }
 
-void ShaderProgram::CompileSource (GLuint shaderID, const std::string& filename) const
+GLenum ShaderProgram::GetSeparableStage () const
 {
-    glCompileShader (shaderID);
-    int success;
-    glGetShaderiv (shaderID, GL_COMPILE_STATUS, &success);
+    return separable ? singleStageType : GL_NONE;
+}
 
-    if (!success)
-    {
-        GLint logLength;
-        glGetShaderiv (shaderID, GL_INFO_LOG_LENGTH, &logLength);
-        GLchar* log = new GLchar[logLength];
-        glGetShaderInfoLog (shaderID, logLength, NULL, log);
-        std::cerr << "Error compiling shader: " << filename << "\n" << log << "\n";
-        delete[] log;
-        exit (EXIT_FAILURE);
-    }
+const std::string& ShaderProgram::GetDefines () const
+{
+    return defines;
 }
 
-void ShaderProgram::LinkBasicShaderProgram () const
+std::uint32_t ShaderProgram::GetGeneration () const
 {
-    glAttachShader (programID, vertexShaderID);
-    glAttachShader (programID, fragmentShaderID);
-    glLinkProgram (programID);
+    return generation;
+}
 
-    glDetachShader (programID, vertexShaderID);
-    glDeleteShader (vertexShaderID);
-    glDetachShader (programID, fragmentShaderID);
-    glDeleteShader (fragmentShaderID);
+const std::vector<std::string>& ShaderProgram::GetSourceFiles () const
+{
+    return sourceFiles;
+}
 
-    GLint success;
-    glGetProgramiv (programID, GL_LINK_STATUS, &success);
+std::vector<ShaderProgram*> ShaderProgram::GetDependentPrograms (const std::string& filename)
+{
+    auto it = dependentPrograms.find (filename);
 
-    if (!success)
-    {
-        GLint logLength;
-        glGetProgramiv (programID, GL_INFO_LOG_LENGTH, &logLength);
-        GLchar* log = new GLchar[logLength];
-        glGetProgramInfoLog (programID, logLength, NULL, log);
-        std::cerr << "Error linking shader: " << programName << "\n" << log << "\n";
-        delete[] log;
-        exit (EXIT_FAILURE);
-    }
+    if (it == dependentPrograms.end ())
+        return std::vector<ShaderProgram*> ();
+
+    return it->second;
 }
 
-void ShaderProgram::LinkShaderProgramWithGeometry () const
+void ShaderProgram::SetBinaryCacheDirectory (const std::string& directory)
 {
-    glAttachShader (programID, vertexShaderID);
-    glAttachShader (programID, geometryShaderID);
-    glAttachShader (programID, fragmentShaderID);
-    glLinkProgram (programID);
+    binaryCacheDirectory = directory;
+}
 
-    glDetachShader (programID, vertexShaderID);
-    glDeleteShader (vertexShaderID);
-    glDetachShader (programID, geometryShaderID);
-    glDeleteShader (geometryShaderID);
-    glDetachShader (programID, fragmentShaderID);
-    glDeleteShader (fragmentShaderID);
+bool ShaderProgram::IsLoadedFromBinaryCache () const
+{
+    return loadedFromBinaryCache;
+}
 
-    GLint success;
-    glGetProgramiv (programID, GL_LINK_STATUS, &success);
+GLint ShaderProgram::GetUniformLocation (const std::string& uniformName) const
+{
+    const UniformInfo* uniform = FindUniform (uniformName.c_str ());
 
-    if (!success)
-    {
-        GLint logLength;
-        glGetProgramiv (programID, GL_INFO_LOG_LENGTH, &logLength);
-        GLchar* log = new GLchar[logLength];
-        glGetProgramInfoLog (programID, logLength, NULL, log);
-        std::cerr << "Error linking shader: " << programName << "\n" << log << "\n";
-        delete[] log;
-        exit (EXIT_FAILURE);
-    }
+    if (uniform)
+        return uniform->location;
+
+    //Every active uniform is in the table, so only array element names like "lights[3]" can still resolve
+    if (uniformName.find ('[') == std::string::npos)
+        return -1;
+
+    return GL ().GetUniformLocation (programID, uniformName.c_str ());
 }
 
-ShaderProgram::~ShaderProgram ()
+const ShaderProgram::UniformInfo* ShaderProgram::FindUniform (const char* uniformName) const
 {
-    glDeleteProgram (programID);
+    auto it = std::lower_bound (uniforms.begin (), uniforms.end (), uniformName, [] (const UniformInfo& uniform, const char* name) { return std::strcmp (uniform.name.c_str (), name) < 0; });
+
+    if (it != uniforms.end () && std::strcmp (it->name.c_str (), uniformName) == 0)
+        return &*it;
+
+    return nullptr;
 }
 
-#pragma region Factory Constructors
+const std::vector<ShaderProgram::UniformInfo>& ShaderProgram::GetActiveUniforms () const
+{
+    return uniforms;
+}
 
-std::unique_ptr<ShaderProgram> ShaderProgram::CreateBasicShaderProgram (const std::string& programName)
+const ShaderProgram::BlockInfo* ShaderProgram::FindUniformBlock (const char* blockName) const
 {
-    std::unique_ptr<ShaderProgram> program (new ShaderProgram ());
+    auto it = std::lower_bound (uniformBlocks.begin (), uniformBlocks.end (), blockName, [] (const BlockInfo& block, const char* name) { return std::strcmp (block.name.c_str (), name) < 0; });
 
-    program->programID = glCreateProgram ();
-    program->vertexShaderID = glCreateShader (GL_VERTEX_SHADER);
-    program->fragmentShaderID = glCreateShader (GL_FRAGMENT_SHADER);
+    if (it != uniformBlocks.end () && std::strcmp (it->name.c_str (), blockName) == 0)
+        return &*it;
 
-    program->programName = programName;
-    program->vertexFilename = programName + ".vert";
-    program->fragmentFilename = programName + ".frag";
+    return nullptr;
+}
 
-    program->LoadSource (program->vertexShaderID, program->vertexFilename);
-    program->CompileSource (program->vertexShaderID, program->vertexFilename);
-    program->LoadSource (program->fragmentShaderID, program->fragmentFilename);
-    program->CompileSource (program->fragmentShaderID, program->fragmentFilename);
-    program->LinkBasicShaderProgram ();
+const std::vector<ShaderProgram::BlockInfo>& ShaderProgram::GetUniformBlocks () const
+{
+    return uniformBlocks;
+}
 
-    return program;
+const ShaderProgram::BlockInfo* ShaderProgram::FindStorageBlock (const char* blockName) const
+{
+    auto it = std::lower_bound (storageBlocks.begin (), storageBlocks.end (), blockName, [] (const BlockInfo& block, const char* name) { return std::strcmp (block.name.c_str (), name) < 0; });
+
+    if (it != storageBlocks.end () && std::strcmp (it->name.c_str (), blockName) == 0)
+        return &*it;
+
+    return nullptr;
 }
 
-std::unique_ptr<ShaderProgram> ShaderProgram::CreateBasicShaderProgramWithNames (const std::string& programName, const std::string& vertexFilename, const std::string& fragmentFilename)
+const std::vector<ShaderProgram::BlockInfo>& ShaderProgram::GetStorageBlocks () const
 {
-    std::unique_ptr<ShaderProgram> program (new ShaderProgram ());
+    return storageBlocks;
+}
 
-    program->programID = glCreateProgram ();
-    program->vertexShaderID = glCreateShader (GL_VERTEX_SHADER);
-    program->fragmentShaderID = glCreateShader (GL_FRAGMENT_SHADER);
+void ShaderProgram::BindStorageBuffer (const char* blockName, GLuint bufferID) const
+{
+    const BlockInfo* block = FindStorageBlock (blockName);
 
-    program->programName = programName;
-    program->vertexFilename = vertexFilename;
-    program->fragmentFilename = fragmentFilename;
+    if (block)
+        GL ().BindBufferBase (GL_SHADER_STORAGE_BUFFER, block->binding, bufferID);
+}
+
+ShaderProgram::UniformWriteMode ShaderProgram::EnableDirectUniformWrites (bool enable)
+{
+    if (!enable)
+        uniformWriteMode = UniformWriteMode::Bound;
+    else if (GL ().HasSeparatePrograms ())
+        uniformWriteMode = UniformWriteMode::DirectStateAccess;
+    else
+        uniformWriteMode = UniformWriteMode::BindAndSet;
+
+    return uniformWriteMode;
+}
 
-    program->LoadSource (program->vertexShaderID, vertexFilename);
-    program->CompileSource (program->vertexShaderID, vertexFilename);
-    program->LoadSource (program->fragmentShaderID, fragmentFilename);
-    program->CompileSource (program->fragmentShaderID, fragmentFilename);
-    program->LinkBasicShaderProgram ();
+ShaderProgram::UniformWriteMode ShaderProgram::GetUniformWriteMode ()
+{
+    return uniformWriteMode;
+}
 
-    return program;
+ShaderProgram::UniformCacheStats ShaderProgram::GetUniformCacheStats () const
+{
+    return cacheStats;
 }
 
-std::unique_ptr<ShaderProgram> ShaderProgram::CreateShaderProgramWithGeometry (const std::string& programName)
+void ShaderProgram::ResetUniformCacheStats ()
 {
-    std::unique_ptr<ShaderProgram> program (new ShaderProgram ());
+    cacheStats = {};
+}
 
-    program->programID = glCreateProgram ();
-    program->vertexShaderID = glCreateShader (GL_VERTEX_SHADER);
-    program->geometryShaderID = glCreateShader (GL_GEOMETRY_SHADER);
-    program->fragmentShaderID = glCreateShader (GL_FRAGMENT_SHADER);
+void ShaderProgram::InvalidateUniformCache () const
+{
+    for (UniformShadow& shadow : shadows)
+        shadow.knownCount = 0;
+}
 
-    program->programName = programName;
-    program->vertexFilename = programName + ".vert";
-    program->geometryFilename = programName + ".geom";
-    program->fragmentFilename = programName + ".frag";
-
-    program->LoadSource (program->vertexShaderID, program->vertexFilename);
-    program->CompileSource (program->vertexShaderID, program->vertexFilename);
-    program->LoadSource (program->geometryShaderID, program->geometryFilename);
-    program->CompileSource (program->geometryShaderID, program->geometryFilename);
-    program->LoadSource (program->fragmentShaderID, program->fragmentFilename);
-    program->CompileSource (program->fragmentShaderID, program->fragmentFilename);
-    program->LinkShaderProgramWithGeometry ();
+GLint ShaderProgram::RemapStaleIndex (std::uint32_t handleGeneration, GLint index) const
+{
+    //A handle from a later generation than the program's was not resolved against this program
+    if (handleGeneration > generation)
+        return -1;
 
-    return program;
+    for (std::uint32_t i = handleGeneration; i < generation && index >= 0; i++)
+        index = reloadedIndices[i][index];
+
+    return index;
 }
 
-std::unique_ptr<ShaderProgram> ShaderProgram::CreateShaderProgramWithGeometryWithNames (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename)
+void ShaderProgram::ReportStaleWrite () const
 {
-    std::unique_ptr<ShaderProgram> program (new ShaderProgram ());
+    if (reportedStaleWrite)
+        return;
 
-    program->programID = glCreateProgram ();
-    program->vertexShaderID = glCreateShader (GL_VERTEX_SHADER);
-    program->geometryShaderID = glCreateShader (GL_GEOMETRY_SHADER);
-    program->fragmentShaderID = glCreateShader (GL_FRAGMENT_SHADER);
+    std::cerr << "Dropping uniform writes through a handle whose uniform is no longer active, or has another type, after the reload of shader: " << programName << "\n";
+    reportedStaleWrite = true;
+}
 
-    program->programName = programName;
-    program->vertexFilename = vertexFilename;
-    program->geometryFilename = geometryFilename;
-    program->fragmentFilename = fragmentFilename;
+GLint ShaderProgram::ElementLocation (GLint index, GLint element) const
+{
+    const UniformShadow& shadow = shadows[index];
 
-    program->LoadSource (program->vertexShaderID, vertexFilename);
-    program->CompileSource (program->vertexShaderID, vertexFilename);
-    program->LoadSource (program->geometryShaderID, geometryFilename);
-    program->CompileSource (program->geometryShaderID, geometryFilename);
-    program->LoadSource (program->fragmentShaderID, fragmentFilename);
-    program->CompileSource (program->fragmentShaderID, fragmentFilename);
-    program->LinkShaderProgramWithGeometry ();
+    if (shadow.contiguous)
+        return uniforms[index].location + element;
 
-    return program;
+    GLint& location = elementLocations[shadow.elementLocations + element];
+
+    if (location == UnresolvedLocation)
+        location = GL ().GetUniformLocation (programID, (uniforms[index].name + "[" + std::to_string (element) + "]").c_str ());
+
+    return location;
 }
 
-#pragma endregion
+const ShaderProgram::UniformInfo* ShaderProgram::FindArrayElement (const char* uniformName, GLint& element) const
+{
+    const char* bracket = std::strchr (uniformName, '[');
 
-GLint ShaderProgram::GetUniformLocation (const std::string& uniformName) const
+    if (!bracket || bracket[1] < '0' || bracket[1] > '9')
+        return nullptr;
+
+    char* end;
+    long index = std::strtol (bracket + 1, &end, 10);
+
+    if (std::strcmp (end, "]") != 0)
+        return nullptr;
+
+    const UniformInfo* found = FindUniform (std::string (uniformName, bracket).c_str ());
+
+    if (!found || index >= found->size)
+        return nullptr;
+
+    element = static_cast<GLint> (index);
+    return found;
+}
+
+bool ShaderProgram::ResolveUniform (const char* uniformName, UniformInfo& uniform) const
+{
+    const UniformInfo* found = FindUniform (uniformName);
+
+    if (found)
+    {
+        uniform = *found;
+        return true;
+    }
+
+    //An element of a reflected array, e.g. "lights[2]", has the array's type and the remaining elements
+    GLint index;
+    found = FindArrayElement (uniformName, index);
+
+    if (!found)
+        return false;
+
+    uniform.name = uniformName;
+    uniform.location = GL ().GetUniformLocation (programID, uniformName);
+    uniform.type = found->type;
+    uniform.size = found->size - index;
+
+    return uniform.location != -1;
+}
+
+void ShaderProgram::ReportUniformTypeMismatch (const char* uniformName, GLenum uniformType, GLenum requestedType) const
 {
-    return glGetUniformLocation (programID, uniformName.c_str ());
+    std::cerr << "Uniform type mismatch in shader: " << programName << "\n" << uniformName << " has GLSL type 0x" << std::hex << uniformType << " but was requested as 0x" << requestedType << std::dec << "\n";
+    exit (EXIT_FAILURE);
 }
 
 #pragma region Float / Vec Uniform Setters
 
 void ShaderProgram::SetUniformFloat (const std::string& uniformName, GLfloat value) const
 {
-    glUniform1f (GetUniformLocation (uniformName), value);
+    StoreByName (uniformName, 1, &value);
 }
 
 void ShaderProgram::SetUniformVec2 (const std::string& uniformName, const glm::vec2& vector) const
 {
-    glUniform2f (GetUniformLocation (uniformName), vector[0], vector[1]);
+    StoreByName (uniformName, 1, &vector);
 }
 
 void ShaderProgram::SetUniformVec3 (const std::string& uniformName, const glm::vec3& vector) const
 {
-    glUniform3f (GetUniformLocation (uniformName), vector[0], vector[1], vector[2]);
+    StoreByName (uniformName, 1, &vector);
 }
 
 void ShaderProgram::SetUniformVec4 (const std::string& uniformName, const glm::vec4& vector) const
 {
-    glUniform4f (GetUniformLocation (uniformName), vector[0], vector[1], vector[2], vector[3]);
+    StoreByName (uniformName, 1, &vector);
 }
 
 #pragma endregion
@@ -251,22 +1354,22 @@ void ShaderProgram::SetUniformVec4 (const std::string& uniformName, const glm::v
 
 void ShaderProgram::SetUniformInt (const std::string& uniformName, GLint value) const
 {
-    glUniform1i (GetUniformLocation (uniformName), value);
+    StoreByName (uniformName, 1, &value);
 }
 
 void ShaderProgram::SetUniformIVec2 (const std::string& uniformName, const glm::ivec2& vector) const
 {
-    glUniform2i (GetUniformLocation (uniformName), vector[0], vector[1]);
+    StoreByName (uniformName, 1, &vector);
 }
 
 void ShaderProgram::SetUniformIVec3 (const std::string& uniformName, const glm::ivec3& vector) const
 {
-    glUniform3i (GetUniformLocation (uniformName), vector[0], vector[1], vector[2]);
+    StoreByName (uniformName, 1, &vector);
 }
 
 void ShaderProgram::SetUniformIVec4 (const std::string& uniformName, const glm::ivec4& vector) const
 {
-    glUniform4i (GetUniformLocation (uniformName), vector[0], vector[1], vector[2], vector[3]);
+    StoreByName (uniformName, 1, &vector);
 }
 
 #pragma endregion
@@ -275,22 +1378,22 @@ void ShaderProgram::SetUniformIVec4 (const std::string& uniformName, const glm::
 
 void ShaderProgram::SetUniformUInt (const std::string& uniformName, GLuint value) const
 {
-    glUniform1ui (GetUniformLocation (uniformName), value);
+    StoreByName (uniformName, 1, &value);
 }
 
 void ShaderProgram::SetUniformUVec2 (const std::string& uniformName, const glm::uvec2& vector) const
 {
-    glUniform2ui (GetUniformLocation (uniformName), vector[0], vector[1]);
+    StoreByName (uniformName, 1, &vector);
 }
 
 void ShaderProgram::SetUniformUVec3 (const std::string& uniformName, const glm::uvec3& vector) const
 {
-    glUniform3ui (GetUniformLocation (uniformName), vector[0], vector[1], vector[2]);
+    StoreByName (uniformName, 1, &vector);
 }
 
 void ShaderProgram::SetUniformUVec4 (const std::string& uniformName, const glm::uvec4& vector) const
 {
-    glUniform4ui (GetUniformLocation (uniformName), vector[0], vector[1], vector[2], vector[3]);
+    StoreByName (uniformName, 1, &vector);
 }
 
 #pragma endregion
@@ -299,22 +1402,42 @@ void ShaderProgram::SetUniformUVec4 (const std::string& uniformName, const glm::
 
 void ShaderProgram::SetUniformFloatArray (const std::string& uniformName, const std::vector<GLfloat>& array) const
 {
-    glUniform1fv (GetUniformLocation (uniformName), array.size (), array.data ());
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformFloatArray (const std::string& uniformName, const GLfloat* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformVec2Array (const std::string& uniformName, const std::vector<glm::vec2>& array) const
 {
-    glUniform2fv (GetUniformLocation (uniformName), array.size (), glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformVec2Array (const std::string& uniformName, const glm::vec2* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformVec3Array (const std::string& uniformName, const std::vector<glm::vec3>& array) const
 {
-    glUniform3fv (GetUniformLocation (uniformName), array.size (), glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformVec3Array (const std::string& uniformName, const glm::vec3* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformVec4Array (const std::string& uniformName, const std::vector<glm::vec4>& array) const
 {
-    glUniform4fv (GetUniformLocation (uniformName), array.size (), glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformVec4Array (const std::string& uniformName, const glm::vec4* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 #pragma endregion
@@ -323,22 +1446,42 @@ void ShaderProgram::SetUniformVec4Array (const std::string& uniformName, const s
 
 void ShaderProgram::SetUniformIntArray (const std::string& uniformName, const std::vector<GLint>& array) const
 {
-    glUniform1iv (GetUniformLocation (uniformName), array.size (), array.data ());
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformIntArray (const std::string& uniformName, const GLint* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformIVec2Array (const std::string& uniformName, const std::vector<glm::ivec2>& array) const
 {
-    glUniform2iv (GetUniformLocation (uniformName), array.size (), glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformIVec2Array (const std::string& uniformName, const glm::ivec2* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformIVec3Array (const std::string& uniformName, const std::vector<glm::ivec3>& array) const
 {
-    glUniform3iv (GetUniformLocation (uniformName), array.size (), glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformIVec3Array (const std::string& uniformName, const glm::ivec3* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformIVec4Array (const std::string& uniformName, const std::vector<glm::ivec4>& array) const
 {
-    glUniform4iv (GetUniformLocation (uniformName), array.size (), glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformIVec4Array (const std::string& uniformName, const glm::ivec4* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 #pragma endregion
@@ -347,22 +1490,42 @@ void ShaderProgram::SetUniformIVec4Array (const std::string& uniformName, const
 
 void ShaderProgram::SetUniformUIntArray (const std::string& uniformName, const std::vector<GLuint>& array) const
 {
-    glUniform1uiv (GetUniformLocation (uniformName), array.size (), array.data ());
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformUIntArray (const std::string& uniformName, const GLuint* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformUVec2Array (const std::string& uniformName, const std::vector<glm::uvec2>& array) const
 {
-    glUniform2uiv (GetUniformLocation (uniformName), array.size (), glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformUVec2Array (const std::string& uniformName, const glm::uvec2* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformUVec3Array (const std::string& uniformName, const std::vector<glm::uvec3>& array) const
 {
-    glUniform3uiv (GetUniformLocation (uniformName), array.size (), glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformUVec3Array (const std::string& uniformName, const glm::uvec3* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformUVec4Array (const std::string& uniformName, const std::vector<glm::uvec4>& array) const
 {
-    glUniform4uiv (GetUniformLocation (uniformName), array.size (), glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformUVec4Array (const std::string& uniformName, const glm::uvec4* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 #pragma endregion
@@ -371,47 +1534,47 @@ void ShaderProgram::SetUniformUVec4Array (const std::string& uniformName, const
 
 void ShaderProgram::SetUniformMat2 (const std::string& uniformName, const glm::mat2& matrix) const
 {
-    glUniformMatrix2fv (GetUniformLocation (uniformName), 1, GL_FALSE, glm::value_ptr (matrix));
+    StoreByName (uniformName, 1, &matrix);
 }
 
 void ShaderProgram::SetUniformMat2x3 (const std::string& uniformName, const glm::mat2x3& matrix) const
 {
-    glUniformMatrix2x3fv (GetUniformLocation (uniformName), 1, GL_FALSE, glm::value_ptr (matrix));
+    StoreByName (uniformName, 1, &matrix);
 }
 
 void ShaderProgram::SetUniformMat2x4 (const std::string& uniformName, const glm::mat2x4& matrix) const
 {
-    glUniformMatrix2x4fv (GetUniformLocation (uniformName), 1, GL_FALSE, glm::value_ptr (matrix));
+    StoreByName (uniformName, 1, &matrix);
 }
 
 void ShaderProgram::SetUniformMat3x2 (const std::string& uniformName, const glm::mat3x2& matrix) const
 {
-    glUniformMatrix3x2fv (GetUniformLocation (uniformName), 1, GL_FALSE, glm::value_ptr (matrix));
+    StoreByName (uniformName, 1, &matrix);
 }
 
 void ShaderProgram::SetUniformMat3 (const std::string& uniformName, const glm::mat3& matrix) const
 {
-    glUniformMatrix3fv (GetUniformLocation (uniformName), 1, GL_FALSE, glm::value_ptr (matrix));
+    StoreByName (uniformName, 1, &matrix);
 }
 
 void ShaderProgram::SetUniformMat3x4 (const std::string& uniformName, const glm::mat3x4& matrix) const
 {
-    glUniformMatrix3x4fv (GetUniformLocation (uniformName), 1, GL_FALSE, glm::value_ptr (matrix));
+    StoreByName (uniformName, 1, &matrix);
 }
 
 void ShaderProgram::SetUniformMat4x2 (const std::string& uniformName, const glm::mat4x2& matrix) const
 {
-    glUniformMatrix4x2fv (GetUniformLocation (uniformName), 1, GL_FALSE, glm::value_ptr (matrix));
+    StoreByName (uniformName, 1, &matrix);
 }
 
 void ShaderProgram::SetUniformMat4x3 (const std::string& uniformName, const glm::mat4x3& matrix) const
 {
-    glUniformMatrix4x3fv (GetUniformLocation (uniformName), 1, GL_FALSE, glm::value_ptr (matrix));
+    StoreByName (uniformName, 1, &matrix);
 }
 
 void ShaderProgram::SetUniformMat4 (const std::string& uniformName, const glm::mat4& matrix) const
 {
-    glUniformMatrix4fv (GetUniformLocation (uniformName), 1, GL_FALSE, glm::value_ptr (matrix));
+    StoreByName (uniformName, 1, &matrix);
 }
 
 #pragma endregion
@@ -420,57 +1583,226 @@ void ShaderProgram::SetUniformMat4 (const std::string& uniformName, const glm::m
 
 void ShaderProgram::SetUniformMat2Array (const std::string& uniformName, const std::vector<glm::mat2>& array) const
 {
-    glUniformMatrix2fv (GetUniformLocation (uniformName), array.size (), GL_FALSE, glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformMat2Array (const std::string& uniformName, const glm::mat2* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformMat2x3Array (const std::string& uniformName, const std::vector<glm::mat2x3>& array) const
 {
-    glUniformMatrix2x3fv (GetUniformLocation (uniformName), array.size (), GL_FALSE, glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformMat2x3Array (const std::string& uniformName, const glm::mat2x3* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformMat2x4Array (const std::string& uniformName, const std::vector<glm::mat2x4>& array) const
 {
-    glUniformMatrix2x4fv (GetUniformLocation (uniformName), array.size (), GL_FALSE, glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformMat2x4Array (const std::string& uniformName, const glm::mat2x4* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformMat3x2Array (const std::string& uniformName, const std::vector<glm::mat3x2>& array) const
 {
-    glUniformMatrix3x2fv (GetUniformLocation (uniformName), array.size (), GL_FALSE, glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformMat3x2Array (const std::string& uniformName, const glm::mat3x2* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformMat3Array (const std::string& uniformName, const std::vector<glm::mat3>& array) const
 {
-    glUniformMatrix3fv (GetUniformLocation (uniformName), array.size (), GL_FALSE, glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformMat3Array (const std::string& uniformName, const glm::mat3* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformMat3x4Array (const std::string& uniformName, const std::vector<glm::mat3x4>& array) const
 {
-    glUniformMatrix3x4fv (GetUniformLocation (uniformName), array.size (), GL_FALSE, glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformMat3x4Array (const std::string& uniformName, const glm::mat3x4* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformMat4x2Array (const std::string& uniformName, const std::vector<glm::mat4x2>& array) const
 {
-    glUniformMatrix4x2fv (GetUniformLocation (uniformName), array.size (), GL_FALSE, glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformMat4x2Array (const std::string& uniformName, const glm::mat4x2* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformMat4x3Array (const std::string& uniformName, const std::vector<glm::mat4x3>& array) const
 {
-    glUniformMatrix4x3fv (GetUniformLocation (uniformName), array.size (), GL_FALSE, glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformMat4x3Array (const std::string& uniformName, const glm::mat4x3* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 void ShaderProgram::SetUniformMat4Array (const std::string& uniformName, const std::vector<glm::mat4>& array) const
 {
-    glUniformMatrix4fv (GetUniformLocation (uniformName), array.size (), GL_FALSE, glm::value_ptr (array[0]));
+    StoreByName (uniformName, array.size (), array.data ());
+}
+
+void ShaderProgram::SetUniformMat4Array (const std::string& uniformName, const glm::mat4* values, GLsizei count, GLint firstElement) const
+{
+    StoreByName (uniformName, count, values, firstElement);
 }
 
 #pragma endregion
 
 void ShaderProgram::SetUniformSampler (const std::string& uniformName, GLint value) const
 {
-    glUniform1i (GetUniformLocation (uniformName), value);
+    StoreByName (uniformName, 1, &value);
 }
 
 void ShaderProgram::UseProgram () const
 {
-    glUseProgram (programID);
+    if (UniformTrace::IsCapturing ())
+        UniformTrace::RecordBind (programName);
+
+    BindProgram ();
+}
+
+//Binds made by the library itself, for BindAndSet writes and dispatches, go through here so a trace only records the application's
+void ShaderProgram::BindProgram () const
+{
+    if (boundProgramID == programID)
+    {
+        bindStats.skipped++;
+        return;
+    }
+
+    GL ().UseProgram (programID);
+    boundProgramID = programID;
+    bindStats.issued++;
+
+    if (ShaderProfiler::IsEnabled ())
+        ShaderProfiler::RecordBind (programName);
+}
+
+void ShaderProgram::InvalidateBoundProgram ()
+{
+    boundProgramID = 0;
+}
+
+ShaderProgram::BindStats ShaderProgram::GetBindStats ()
+{
+    return bindStats;
+}
+
+void ShaderProgram::ResetBindStats ()
+{
+    bindStats = {};
+}
+
+#pragma region Compute Dispatch
+
+glm::uvec3 ShaderProgram::GetWorkGroupSize () const
+{
+    return glm::uvec3 (workGroupSize[0], workGroupSize[1], workGroupSize[2]);
+}
+
+void ShaderProgram::RequireCompute () const
+{
+    if (computeFilename.empty ())
+    {
+        std::cerr << "Cannot dispatch shader program without a compute shader: " << programName << "\n";
+        exit (EXIT_FAILURE);
+    }
+}
+
+void ShaderProgram::Dispatch (GLuint groupsX, GLuint groupsY, GLuint groupsZ) const
+{
+    RequireCompute ();
+    BindProgram ();
+    GL ().DispatchCompute (groupsX, groupsY, groupsZ);
+}
+
+void ShaderProgram::DispatchInvocations (GLuint invocationsX, GLuint invocationsY, GLuint invocationsZ) const
+{
+    RequireCompute ();
+
+    //Round up, so every invocation is covered; the shader must ignore the ones past the end of the data
+    Dispatch ((invocationsX + workGroupSize[0] - 1) / workGroupSize[0], (invocationsY + workGroupSize[1] - 1) / workGroupSize[1], (invocationsZ + workGroupSize[2] - 1) / workGroupSize[2]);
+}
+
+void ShaderProgram::DispatchIndirect (GLintptr offset) const
+{
+    RequireCompute ();
+    BindProgram ();
+    GL ().DispatchComputeIndirect (offset);
+}
+
+void ShaderProgram::DispatchIndirect (GLuint bufferID, GLintptr offset) const
+{
+    GL ().BindBuffer (GL_DISPATCH_INDIRECT_BUFFER, bufferID);
+    DispatchIndirect (offset);
+}
+
+void ShaderProgram::Barrier (GLbitfield barriers)
+{
+    GL ().MemoryBarrier (barriers);
+}
+
+void ShaderProgram::StorageBarrier ()
+{
+    GL ().MemoryBarrier (GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void ShaderProgram::ImageBarrier ()
+{
+    GL ().MemoryBarrier (GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void ShaderProgram::VertexBarrier ()
+{
+    GL ().MemoryBarrier (GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT);
+}
+
+void ShaderProgram::CommandBarrier ()
+{
+    GL ().MemoryBarrier (GL_COMMAND_BARRIER_BIT);
+}
+
+#pragma endregion
+
+PendingShaderProgram::PendingShaderProgram (std::unique_ptr<ShaderProgram> program)
+    : program (std::move (program))
+{
+}
+
+bool PendingShaderProgram::IsReady () const
+{
+    return !program || program->IsLinkComplete ();
+}
+
+std::unique_ptr<ShaderProgram> PendingShaderProgram::Wait ()
+{
+    if (program && !program->CheckLinkStatus ())
+        exit (EXIT_FAILURE);
+
+    return std::move (program);
 }
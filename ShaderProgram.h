@@ -1,36 +1,280 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <GL/glew.h>
 
 #include <glm/matrix.hpp>
 
+#include "ShaderProfiler.h"
+#include "ShaderStage.h"
+#include "UniformHandle.h"
+#include "UniformTrace.h"
+
+class PendingShaderProgram;
+class ShaderSource;
+class ShaderWatcher;
+
+template <typename T>
+class StorageBuffer;
+
 /// <summary>
 /// Represents a GLSL shader program.
 /// </summary>
 class ShaderProgram
 {
+public:
+    /// <summary>
+    /// Describes an active uniform, as reflected from the program after linking.
+    /// </summary>
+    struct UniformInfo
+    {
+        /// <summary>
+        /// The name of the uniform. Arrays are stored under their base name, without the "[0]" suffix.
+        /// </summary>
+        std::string name;
+        GLint location;
+        GLenum type;
+        GLint size;
+    };
+
+    /// <summary>
+    /// Describes a member of a uniform block, with its layout in the block's buffer as reported by GL.
+    /// </summary>
+    struct BlockMemberInfo
+    {
+        std::string name;
+        GLenum type;
+        GLint size;
+        GLint offset;
+        GLint arrayStride;
+        GLint matrixStride;
+    };
+
+    /// <summary>
+    /// Describes an active uniform or shader storage block and the binding point it reads its buffer from.
+    /// </summary>
+    struct BlockInfo
+    {
+        std::string name;
+        GLuint index;
+        GLint dataSize;
+        GLuint binding;
+        /// <summary>
+        /// The members of the block, sorted by offset. The size of a trailing unsized array is reported as 0.
+        /// </summary>
+        std::vector<BlockMemberInfo> members;
+    };
+
+    /// <summary>
+    /// A value for a SPIR-V specialization constant, identified by its constant_id. The value is the 32-bit pattern of the constant,
+    /// so floats are passed by their bits; use the helpers to build one from a typed value.
+    /// </summary>
+    struct SpecializationConstant
+    {
+        GLuint id;
+        GLuint value;
+
+        static SpecializationConstant Int (GLuint id, GLint value)
+        {
+            return { id, static_cast<GLuint> (value) };
+        }
+
+        static SpecializationConstant UInt (GLuint id, GLuint value)
+        {
+            return { id, value };
+        }
+
+        static SpecializationConstant Float (GLuint id, GLfloat value)
+        {
+            SpecializationConstant constant = { id, 0 };
+            std::memcpy (&constant.value, &value, sizeof (value));
+            return constant;
+        }
+
+        static SpecializationConstant Bool (GLuint id, bool value)
+        {
+            return { id, value ? GLuint (GL_TRUE) : GLuint (GL_FALSE) };
+        }
+    };
+
+    /// <summary>
+    /// Counts uniform writes that were dropped because the program already held the value (hits) and writes that reached GL (misses).
+    /// </summary>
+    struct UniformCacheStats
+    {
+        std::uint64_t hits;
+        std::uint64_t misses;
+    };
+
+    /// <summary>
+    /// How the uniform setters reach GL.
+    /// Bound writes with glUniform* to the program bound in the current context, which the caller must have bound with UseProgram.
+    /// DirectStateAccess writes with glProgramUniform* to the program itself, whether it is bound or not.
+    /// BindAndSet binds the program for each write that reaches GL and then restores the program, or pipeline, bound before, for
+    /// contexts without glProgramUniform*.
+    /// </summary>
+    enum class UniformWriteMode
+    {
+        Bound,
+        DirectStateAccess,
+        BindAndSet
+    };
+
+    /// <summary>
+    /// Counts UseProgram calls that reached glUseProgram (issued) and calls dropped because the program was already bound (skipped).
+    /// </summary>
+    struct BindStats
+    {
+        std::uint64_t issued;
+        std::uint64_t skipped;
+    };
+
 private:
+    // The program last bound through UseProgram. GL contexts are current per thread, so this tracks the current context.
+    static thread_local GLuint boundProgramID;
+    static thread_local BindStats bindStats;
+
+    // Directory holding program binaries keyed by source and driver; empty when the cache is disabled
+    static std::string binaryCacheDirectory;
+    static thread_local bool parallelCompileEnabled;
+    static thread_local UniformWriteMode uniformWriteMode;
+
+    // While a watcher exists, programs keep their stages for reloading and tell it when they are destroyed
+    static ShaderWatcher* watcher;
+    std::string binaryCachePath;
+
+    // CPU-side copy of the values of one active uniform, parallel to uniforms
+    struct UniformShadow
+    {
+        size_t offset;
+        GLsizei elementSize;
+        // Elements [0, knownCount) hold the value last written to GL
+        GLint knownCount;
+        // Whether element k is at location + k; otherwise element locations are cached in elementLocations from this offset
+        bool contiguous;
+        size_t elementLocations;
+    };
+
+    static constexpr GLint UnresolvedLocation = -2;
+
     GLuint programID;
-    GLuint vertexShaderID;
-    GLuint geometryShaderID;
-    GLuint fragmentShaderID;
+
+    // Stages are held only until the program is linked; identical stages are shared between pending programs
+    std::shared_ptr<ShaderStage> vertexStage;
+    std::shared_ptr<ShaderStage> geometryStage;
+    std::shared_ptr<ShaderStage> fragmentStage;
+    std::shared_ptr<ShaderStage> computeStage;
 
     std::string programName;
     std::string vertexFilename;
     std::string geometryFilename;
     std::string fragmentFilename;
-
-    void LoadSource (GLuint shaderID, const std::string& filename) const;
+    // Set only for compute programs, which have no other stage
+    std::string computeFilename;
+
+    GLint workGroupSize[3] = { 1, 1, 1 };
+
+    // Injected after the #version line of every stage, e.g. by ShaderVariants
+    std::string defines;
+
+    // The stage of a program built from a single file (compute or separable), or GL_NONE
+    GLenum singleStageType = GL_NONE;
+    bool separable = false;
+    // Built from SPIR-V modules rather than GLSL source; such programs have no source files and are not reloaded
+    bool spirv = false;
+
+    // Every file the stages were built from, including included files, and the reverse index over all programs
+    std::vector<std::string> sourceFiles;
+    static std::unordered_map<std::string, std::vector<ShaderProgram*>> dependentPrograms;
+    static std::uint64_t sourceFilesVersion;
+
+    // Incremented each time a reload swaps in a rebuilt program
+    std::uint32_t generation = 0;
+    // For the reload that ended each generation, the index each uniform of the old table has in the new one, or -1 if it is gone
+    std::vector<std::vector<GLint>> reloadedIndices;
+    // Whether a write through a handle that no longer matches an active uniform was reported since the last reload
+    mutable bool reportedStaleWrite = false;
+
+    // Active uniforms, sorted by name so lookups are a binary search over one contiguous block.
+    std::vector<UniformInfo> uniforms;
+
+    // Active uniform blocks, sorted by name
+    std::vector<BlockInfo> uniformBlocks;
+    // Active shader storage blocks, sorted by name; empty when the context does not support them
+    std::vector<BlockInfo> storageBlocks;
+
+    mutable std::vector<UniformShadow> shadows;
+    mutable std::vector<unsigned char> shadowValues;
+    mutable std::vector<GLint> elementLocations;
+    mutable UniformCacheStats cacheStats = {};
+
+    bool loadedFromBinaryCache = false;
+
+    std::shared_ptr<ShaderStage> AcquireStage (GLenum type, const ShaderSource& source) const;
+    void LoadSource (GLuint shaderID, const ShaderSource& source) const;
+    void RegisterSourceFiles (const std::vector<const ShaderSource*>& sources);
+    void UnregisterSourceFiles ();
+    void AdoptProgram (ShaderProgram& rebuilt);
     void CompileSource (GLuint shaderID, const std::string& filename) const;
-    void LinkBasicShaderProgram () const;
-    void LinkShaderProgramWithGeometry () const;
+    std::shared_ptr<ShaderStage> AcquireSpirvStage (GLenum type, const std::string& filename, const std::vector<SpecializationConstant>& constants) const;
+    bool CheckCompileStatus (GLuint shaderID, const std::string& filename) const;
+    void LinkProgram () const;
+    bool CheckLinkStatus ();
+    void ReleaseStages ();
+    bool IsLinkComplete () const;
+    void ReflectUniforms ();
+    void ReflectUniformBlocks ();
+    void ReflectStorageBlocks ();
+    bool LoadCachedBinary (const std::vector<const ShaderSource*>& sources);
+    bool CheckCachedBinaryLink ();
+    void StoreCachedBinary () const;
+    bool ResolveUniform (const char* uniformName, UniformInfo& uniform) const;
+    const UniformInfo* FindArrayElement (const char* uniformName, GLint& element) const;
+    [[noreturn]] void ReportUniformTypeMismatch (const char* uniformName, GLenum uniformType, GLenum requestedType) const;
+
+    template <typename T>
+    void Store (GLint index, GLint location, GLint element, GLsizei count, const T* data) const;
+    template <typename T>
+    void StoreStale (std::uint32_t handleGeneration, GLint index, GLint element, GLsizei count, const T* data) const;
+    GLint RemapStaleIndex (std::uint32_t handleGeneration, GLint index) const;
+    void ReportStaleWrite () const;
+    template <typename T>
+    void Upload (GLint location, GLsizei count, const T* data) const;
+    template <typename T>
+    void StoreByName (const std::string& uniformName, GLsizei count, const T* data, GLint firstElement = 0) const;
+    GLint ElementLocation (GLint index, GLint element) const;
+    void BindProgram () const;
+
+    static bool SupportsParallelCompile ();
+
+    void RequireCompute () const;
+    std::shared_ptr<ShaderStage>* StageSlot (GLenum stageType);
+    std::string* FilenameSlot (GLenum stageType);
+    static void EnableParallelCompile ();
+    static std::unique_ptr<ShaderProgram> SubmitStages (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename, const std::string& defines = std::string ());
+    static std::unique_ptr<ShaderProgram> SubmitSingleStage (const std::string& programName, GLenum stageType, const std::string& filename, bool separable, const std::string& defines = std::string ());
+    static std::unique_ptr<ShaderProgram> Submit (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename, const std::string& defines = std::string ());
+    static std::unique_ptr<ShaderProgram> SubmitSpirv (const std::string& programName, const std::vector<std::pair<GLenum, std::string>>& stages, const std::vector<SpecializationConstant>& constants);
+    static void RequireSpirv (const std::string& programName);
 
     ShaderProgram () = default;
 
+    friend class PendingShaderProgram;
+    friend class ProgramPipeline;
+    friend class ShaderLibrary;
+    friend class ShaderVariants;
+    friend class UniformCommandBuffer;
+    friend class UniformTrace;
+    friend class ShaderWatcher;
+
 public:
     ~ShaderProgram ();
 
@@ -69,6 +313,166 @@ public:
     /// <param name="fragmentFilename">The fragment shader file.</param>
     static std::unique_ptr<ShaderProgram> CreateShaderProgramWithGeometryWithNames (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename);
 
+    /// <summary>
+    /// Creates a shader program with a compute shader.
+    /// </summary>
+    /// <param name="programName">
+    /// The name of the program. The compute shader file should be named programName + ".comp".
+    /// </param>
+    static std::unique_ptr<ShaderProgram> CreateComputeProgram (const std::string& programName);
+
+    /// <summary>
+    /// Creates a shader program with a compute shader, with a custom filename.
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    /// <param name="computeFilename">The compute shader file.</param>
+    static std::unique_ptr<ShaderProgram> CreateComputeProgramWithName (const std::string& programName, const std::string& computeFilename);
+
+    /// <summary>
+    /// Creates a separable shader program with a single stage, to be combined with other stages in a ProgramPipeline.
+    /// N vertex and M fragment programs then cost N + M links instead of one per combination.
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    /// <param name="stageType">The stage: GL_VERTEX_SHADER, GL_GEOMETRY_SHADER or GL_FRAGMENT_SHADER.</param>
+    /// <param name="filename">The shader file.</param>
+    static std::unique_ptr<ShaderProgram> CreateSeparableProgram (const std::string& programName, GLenum stageType, const std::string& filename);
+
+#pragma endregion
+
+#pragma region SPIR-V Factory Constructors
+
+    /// <summary>
+    /// Creates a shader program from precompiled SPIR-V vertex and fragment modules, skipping GLSL compilation.
+    /// Requires GL 4.6 or ARB_gl_spirv. Each module is specialized at its "main" entry point.
+    /// Drivers need not reflect the debug names of SPIR-V uniforms; a uniform reported without a name is set by its location,
+    /// written as the name "#location", for example "#3".
+    /// </summary>
+    /// <param name="programName">
+    /// The name of the program. The vertex module should be named programName + ".vert.spv" and the fragment module programName + ".frag.spv".
+    /// </param>
+    /// <param name="constants">Values for specialization constants. Each module receives the ones it declares; the others keep their defaults.</param>
+    static std::unique_ptr<ShaderProgram> CreateSpirvProgram (const std::string& programName, const std::vector<SpecializationConstant>& constants = {});
+
+    /// <summary>
+    /// Creates a shader program from precompiled SPIR-V vertex and fragment modules, with custom filenames.
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    /// <param name="vertexFilename">The vertex module.</param>
+    /// <param name="fragmentFilename">The fragment module.</param>
+    /// <param name="constants">Values for specialization constants.</param>
+    static std::unique_ptr<ShaderProgram> CreateSpirvProgramWithNames (const std::string& programName, const std::string& vertexFilename, const std::string& fragmentFilename, const std::vector<SpecializationConstant>& constants = {});
+
+    /// <summary>
+    /// Creates a shader program from precompiled SPIR-V vertex, geometry and fragment modules.
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    /// <param name="vertexFilename">The vertex module.</param>
+    /// <param name="geometryFilename">The geometry module.</param>
+    /// <param name="fragmentFilename">The fragment module.</param>
+    /// <param name="constants">Values for specialization constants.</param>
+    static std::unique_ptr<ShaderProgram> CreateSpirvProgramWithGeometryWithNames (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename, const std::vector<SpecializationConstant>& constants = {});
+
+    /// <summary>
+    /// Creates a compute program from a precompiled SPIR-V module. Specialization constants may also size the work group.
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    /// <param name="computeFilename">The compute module.</param>
+    /// <param name="constants">Values for specialization constants.</param>
+    static std::unique_ptr<ShaderProgram> CreateSpirvComputeProgramWithName (const std::string& programName, const std::string& computeFilename, const std::vector<SpecializationConstant>& constants = {});
+
+#pragma endregion
+
+#pragma region Asynchronous Factory Constructors
+
+    /// <summary>
+    /// Submits a shader program with vertex and fragment shaders to the driver without waiting for it to compile and link.
+    /// </summary>
+    /// <param name="programName">
+    /// The name of the program. The vertex shader file should be named programName + ".vert" and the fragment shader file should be named programName + ".frag".
+    /// </param>
+    static std::unique_ptr<PendingShaderProgram> CreateBasicShaderProgramAsync (const std::string& programName);
+
+    /// <summary>
+    /// Submits a shader program with vertex and fragment shaders, with custom filenames, without waiting for it to compile and link.
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    /// <param name="vertexFilename">The vertex shader file.</param>
+    /// <param name="fragmentFilename">The fragment shader file.</param>
+    static std::unique_ptr<PendingShaderProgram> CreateBasicShaderProgramWithNamesAsync (const std::string& programName, const std::string& vertexFilename, const std::string& fragmentFilename);
+
+    /// <summary>
+    /// Submits a shader program with vertex, geometry, and fragment shaders without waiting for it to compile and link.
+    /// </summary>
+    /// <param name="programName">
+    /// The name of the program. The vertex shader file should be named programName + ".vert", the geometry shader file should be  named programName + ".geom, and the fragment shader file should be named programName + ".frag".
+    /// </param>
+    static std::unique_ptr<PendingShaderProgram> CreateShaderProgramWithGeometryAsync (const std::string& programName);
+
+    /// <summary>
+    /// Submits a shader program with vertex, geometry, and fragment shaders, with custom filenames, without waiting for it to compile and link.
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    /// <param name="vertexFilename">The vertex shader file.</param>
+    /// <param name="geometryFilename">The geometry shader file.</param>
+    /// <param name="fragmentFilename">The fragment shader file.</param>
+    static std::unique_ptr<PendingShaderProgram> CreateShaderProgramWithGeometryWithNamesAsync (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename);
+
+#pragma endregion
+
+    /// <summary>
+    /// Returns whether the program was created with CreateSeparableProgram.
+    /// </summary>
+    bool IsSeparable () const;
+
+    /// <summary>
+    /// Returns the stage of a separable program, or GL_NONE if the program is not separable.
+    /// </summary>
+    GLenum GetSeparableStage () const;
+
+    /// <summary>
+    /// Returns the #define lines injected into every stage of the program, or an empty string.
+    /// </summary>
+    const std::string& GetDefines () const;
+
+#pragma region Source Dependencies
+
+    /// <summary>
+    /// Returns every file the program's stages were built from, including files pulled in through #include.
+    /// </summary>
+    const std::vector<std::string>& GetSourceFiles () const;
+
+    /// <summary>
+    /// Returns every live program built from a file, either as a stage or through an #include.
+    /// </summary>
+    /// <param name="filename">The file, spelled as in the program's filenames or include directives.</param>
+    static std::vector<ShaderProgram*> GetDependentPrograms (const std::string& filename);
+
+    /// <summary>
+    /// Returns how many times the program has been replaced by a hot reload.
+    /// Uniform handles obtained before a reload keep working: writes through them, directly or recorded in a UniformCommandBuffer,
+    /// go to the uniform of the same name in the reloaded program. Writes to a uniform that is no longer active, or no longer
+    /// accepts the handle's type, are dropped, and the first of them after each reload is reported.
+    /// </summary>
+    std::uint32_t GetGeneration () const;
+
+#pragma endregion
+
+#pragma region Program Binary Cache
+
+    /// <summary>
+    /// Enables the on-disk program binary cache. The factory constructors then load a program through glProgramBinary
+    /// when its stage sources and the GL driver are unchanged, and store newly linked programs for the next run.
+    /// Binaries the driver rejects are rebuilt from source. Binaries packed into a mounted ShaderBundle are tried first,
+    /// and are used even when the cache directory is disabled.
+    /// </summary>
+    /// <param name="directory">An existing directory to hold the cached binaries, or an empty string to disable the cache.</param>
+    static void SetBinaryCacheDirectory (const std::string& directory);
+
+    /// <summary>
+    /// Returns whether the program was loaded from the binary cache rather than compiled from source.
+    /// </summary>
+    bool IsLoadedFromBinaryCache () const;
+
 #pragma endregion
 
     /// <summary>
@@ -77,6 +481,120 @@ public:
     /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
     GLint GetUniformLocation (const std::string& uniformName) const;
 
+    /// <summary>
+    /// Returns the reflected description of an active uniform, or nullptr if the program has no active uniform with that name.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    const UniformInfo* FindUniform (const char* uniformName) const;
+
+    /// <summary>
+    /// Returns all active uniforms of the program, sorted by name.
+    /// </summary>
+    const std::vector<UniformInfo>& GetActiveUniforms () const;
+
+    /// <summary>
+    /// Returns the reflected description of an active uniform block, or nullptr if the program has no active block with that name.
+    /// Every block is bound to the binding point UniformBuffer assigns to its name, so a UniformBuffer created for the name feeds it.
+    /// A block declared with layout (binding = N), N > 0, or in a SPIR-V program keeps its binding, and the name is given that point.
+    /// </summary>
+    /// <param name="blockName">The name of the block as it appears in the shader code.</param>
+    const BlockInfo* FindUniformBlock (const char* blockName) const;
+
+    /// <summary>
+    /// Returns all active uniform blocks of the program, sorted by name.
+    /// </summary>
+    const std::vector<BlockInfo>& GetUniformBlocks () const;
+
+    /// <summary>
+    /// Returns the reflected description of an active shader storage block, or nullptr if the program has no active block with that name.
+    /// Every block is bound to the binding point GetStorageBindingPoint assigns to its name, except for declared bindings, which are
+    /// kept as for uniform blocks.
+    /// </summary>
+    /// <param name="blockName">The name of the block as it appears in the shader code.</param>
+    const BlockInfo* FindStorageBlock (const char* blockName) const;
+
+    /// <summary>
+    /// Returns all active shader storage blocks of the program, sorted by name.
+    /// </summary>
+    const std::vector<BlockInfo>& GetStorageBlocks () const;
+
+    /// <summary>
+    /// Binds a buffer to the binding point of a shader storage block. Does nothing if the block is not active in the program.
+    /// The binding is shared by every program that declares a block with the same name.
+    /// </summary>
+    /// <param name="blockName">The name of the block as it appears in the shader code.</param>
+    /// <param name="bufferID">The buffer to bind.</param>
+    void BindStorageBuffer (const char* blockName, GLuint bufferID) const;
+
+    /// <summary>
+    /// Binds a storage buffer to the binding point of a shader storage block. Does nothing if the block is not active in the program.
+    /// </summary>
+    /// <param name="blockName">The name of the block as it appears in the shader code.</param>
+    /// <param name="buffer">The buffer to bind.</param>
+    template <typename T>
+    void BindStorageBuffer (const char* blockName, const StorageBuffer<T>& buffer) const;
+
+    /// <summary>
+    /// Lets the uniform setters of every program write without the program being bound, for the current context.
+    /// Uses glProgramUniform* (GL 4.1 or ARB_separate_shader_objects) when available, and otherwise falls back to binding the
+    /// program before each write. With direct writes, programs that are not bound can be set up without any binding changes,
+    /// and ProgramPipeline::SetActiveProgram is not needed.
+    /// </summary>
+    /// <param name="enable">Whether to write without requiring a bound program, or go back to writing to the bound program.</param>
+    /// <returns>The mode now in use.</returns>
+    static UniformWriteMode EnableDirectUniformWrites (bool enable);
+
+    /// <summary>
+    /// Returns how the uniform setters reach GL in the current context.
+    /// </summary>
+    static UniformWriteMode GetUniformWriteMode ();
+
+    /// <summary>
+    /// Returns how many uniform writes were skipped as redundant and how many were passed to GL.
+    /// </summary>
+    UniformCacheStats GetUniformCacheStats () const;
+
+    /// <summary>
+    /// Resets the uniform cache counters to zero.
+    /// </summary>
+    void ResetUniformCacheStats ();
+
+    /// <summary>
+    /// Forgets the cached uniform values, so the next write to every uniform reaches GL.
+    /// Call this after writing the program's uniforms through GL directly.
+    /// </summary>
+    void InvalidateUniformCache () const;
+
+#pragma region Typed Uniform Handles
+
+    /// <summary>
+    /// Resolves a uniform once and returns a handle for writing it without any further lookup.
+    /// Exits if the uniform is active but its GLSL type cannot be written from T.
+    /// </summary>
+    /// <typeparam name="T">The C++ type that will be written to the uniform, e.g. glm::mat4.</typeparam>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code, or an array element such as "lights[2]".</param>
+    template <typename T>
+    UniformHandle<T> GetUniform (const char* uniformName) const;
+
+    /// <summary>
+    /// Sets a uniform through a handle obtained from this program.
+    /// </summary>
+    /// <param name="uniform">The handle of the uniform.</param>
+    /// <param name="value">The value to pass to the uniform.</param>
+    template <typename T>
+    void Set (const UniformHandle<T>& uniform, const T& value) const;
+
+    /// <summary>
+    /// Sets consecutive elements of an array uniform through a handle obtained from this program.
+    /// </summary>
+    /// <param name="uniform">The handle of the uniform.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    template <typename T>
+    void Set (const UniformHandle<T>& uniform, const T* values, GLsizei count) const;
+
+#pragma endregion
+
 #pragma region Float / Vec Uniform Setters
 
     /// <summary>
@@ -182,6 +700,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformFloatArray (const std::string& uniformName, const std::vector<GLfloat>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of floating point values in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformFloatArray (const std::string& uniformName, const GLfloat* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of vec2's in the program.
     /// </summary>
@@ -189,6 +717,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformVec2Array (const std::string& uniformName, const std::vector<glm::vec2>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of vec2's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformVec2Array (const std::string& uniformName, const glm::vec2* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of vec3's in the program.
     /// </summary>
@@ -196,6 +734,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformVec3Array (const std::string& uniformName, const std::vector<glm::vec3>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of vec3's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformVec3Array (const std::string& uniformName, const glm::vec3* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of vec4's in the program.
     /// </summary>
@@ -203,6 +751,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformVec4Array (const std::string& uniformName, const std::vector<glm::vec4>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of vec4's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformVec4Array (const std::string& uniformName, const glm::vec4* values, GLsizei count, GLint firstElement = 0) const;
+
 #pragma endregion
 
 #pragma region Int / IVec Array Uniform Setters
@@ -214,6 +772,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformIntArray (const std::string& uniformName, const std::vector<GLint>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of integer values in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformIntArray (const std::string& uniformName, const GLint* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of ivec2's in the program.
     /// </summary>
@@ -221,6 +789,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformIVec2Array (const std::string& uniformName, const std::vector<glm::ivec2>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of ivec2's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformIVec2Array (const std::string& uniformName, const glm::ivec2* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of ivec3's in the program.
     /// </summary>
@@ -228,6 +806,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformIVec3Array (const std::string& uniformName, const std::vector<glm::ivec3>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of ivec3's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformIVec3Array (const std::string& uniformName, const glm::ivec3* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of ivec4's in the program.
     /// </summary>
@@ -235,6 +823,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformIVec4Array (const std::string& uniformName, const std::vector<glm::ivec4>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of ivec4's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformIVec4Array (const std::string& uniformName, const glm::ivec4* values, GLsizei count, GLint firstElement = 0) const;
+
 #pragma endregion
 
 #pragma region UInt / UVec Array Uniform Setters
@@ -246,6 +844,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformUIntArray (const std::string& uniformName, const std::vector<GLuint>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of unsigned integer values in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformUIntArray (const std::string& uniformName, const GLuint* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of uvec2's in the program.
     /// </summary>
@@ -253,6 +861,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformUVec2Array (const std::string& uniformName, const std::vector<glm::uvec2>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of uvec2's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformUVec2Array (const std::string& uniformName, const glm::uvec2* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of uvec3's in the program.
     /// </summary>
@@ -260,6 +878,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformUVec3Array (const std::string& uniformName, const std::vector<glm::uvec3>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of uvec3's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformUVec3Array (const std::string& uniformName, const glm::uvec3* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of uvec4's in the program.
     /// </summary>
@@ -267,6 +895,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformUVec4Array (const std::string& uniformName, const std::vector<glm::uvec4>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of uvec4's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformUVec4Array (const std::string& uniformName, const glm::uvec4* values, GLsizei count, GLint firstElement = 0) const;
+
 #pragma endregion
 
 #pragma region Matrix Uniform Setters
@@ -345,6 +983,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformMat2Array (const std::string& uniformName, const std::vector<glm::mat2>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of mat2's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformMat2Array (const std::string& uniformName, const glm::mat2* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of mat2x3's in the program.
     /// </summary>
@@ -352,6 +1000,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformMat2x3Array (const std::string& uniformName, const std::vector<glm::mat2x3>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of mat2x3's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformMat2x3Array (const std::string& uniformName, const glm::mat2x3* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of mat2x4's in the program.
     /// </summary>
@@ -359,6 +1017,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformMat2x4Array (const std::string& uniformName, const std::vector<glm::mat2x4>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of mat2x4's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformMat2x4Array (const std::string& uniformName, const glm::mat2x4* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of mat3x2's in the program.
     /// </summary>
@@ -366,6 +1034,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformMat3x2Array (const std::string& uniformName, const std::vector<glm::mat3x2>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of mat3x2's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformMat3x2Array (const std::string& uniformName, const glm::mat3x2* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of mat3's in the program.
     /// </summary>
@@ -373,6 +1051,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformMat3Array (const std::string& uniformName, const std::vector<glm::mat3>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of mat3's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformMat3Array (const std::string& uniformName, const glm::mat3* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of mat3x4's in the program.
     /// </summary>
@@ -380,6 +1068,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformMat3x4Array (const std::string& uniformName, const std::vector<glm::mat3x4>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of mat3x4's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformMat3x4Array (const std::string& uniformName, const glm::mat3x4* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of mat4x2's in the program.
     /// </summary>
@@ -387,6 +1085,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformMat4x2Array (const std::string& uniformName, const std::vector<glm::mat4x2>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of mat4x2's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformMat4x2Array (const std::string& uniformName, const glm::mat4x2* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of mat4x3's in the program.
     /// </summary>
@@ -394,6 +1102,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformMat4x3Array (const std::string& uniformName, const std::vector<glm::mat4x3>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of mat4x3's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformMat4x3Array (const std::string& uniformName, const glm::mat4x3* values, GLsizei count, GLint firstElement = 0) const;
+
     /// <summary>
     /// Sets an array uniform of mat4's in the program.
     /// </summary>
@@ -401,6 +1119,16 @@ public:
     /// <param name="array">The array to pass to the uniform.</param>
     void SetUniformMat4Array (const std::string& uniformName, const std::vector<glm::mat4>& array) const;
 
+    /// <summary>
+    /// Sets a range of elements of an array uniform of mat4's in the program, reading from memory owned by the caller.
+    /// Only the elements that differ from the last values written are uploaded.
+    /// </summary>
+    /// <param name="uniformName">The name of the uniform as it appears in the shader code.</param>
+    /// <param name="values">The values to pass to the uniform.</param>
+    /// <param name="count">The number of values.</param>
+    /// <param name="firstElement">The array element the first value is written to.</param>
+    void SetUniformMat4Array (const std::string& uniformName, const glm::mat4* values, GLsizei count, GLint firstElement = 0) const;
+
 #pragma endregion
 
     /// <summary>
@@ -411,7 +1139,312 @@ public:
     void SetUniformSampler (const std::string& uniformName, GLint samplerID) const;
 
     /// <summary>
-    /// Sets the program to the active program.
+    /// Sets the program to the active program. Does nothing if it is already the active program of the current context.
     /// </summary>
     void UseProgram () const;
+
+    /// <summary>
+    /// Forgets which program is bound in the current context, so the next UseProgram reaches GL.
+    /// Call this after calling glUseProgram directly or making another context current on this thread.
+    /// </summary>
+    static void InvalidateBoundProgram ();
+
+#pragma region Compute Dispatch
+
+    /// <summary>
+    /// Returns the local size of the compute shader, as declared by its layout (local_size_x, ...) qualifier.
+    /// Returns (1, 1, 1) for programs without a compute shader.
+    /// </summary>
+    glm::uvec3 GetWorkGroupSize () const;
+
+    /// <summary>
+    /// Binds the program and launches a grid of work groups. Exits if the program has no compute shader.
+    /// </summary>
+    /// <param name="groupsX">The number of work groups in X.</param>
+    /// <param name="groupsY">The number of work groups in Y.</param>
+    /// <param name="groupsZ">The number of work groups in Z.</param>
+    void Dispatch (GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1) const;
+
+    /// <summary>
+    /// Binds the program and launches enough work groups to cover a number of invocations, e.g. one per particle.
+    /// Exits if the program has no compute shader.
+    /// </summary>
+    /// <param name="invocationsX">The number of invocations in X.</param>
+    /// <param name="invocationsY">The number of invocations in Y.</param>
+    /// <param name="invocationsZ">The number of invocations in Z.</param>
+    void DispatchInvocations (GLuint invocationsX, GLuint invocationsY = 1, GLuint invocationsZ = 1) const;
+
+    /// <summary>
+    /// Binds the program and launches the work groups given by the buffer bound to GL_DISPATCH_INDIRECT_BUFFER.
+    /// Exits if the program has no compute shader.
+    /// </summary>
+    /// <param name="offset">The byte offset of the three GLuint group counts in the buffer.</param>
+    void DispatchIndirect (GLintptr offset = 0) const;
+
+    /// <summary>
+    /// Binds a buffer to GL_DISPATCH_INDIRECT_BUFFER, then binds the program and launches the work groups given by the buffer.
+    /// Exits if the program has no compute shader.
+    /// </summary>
+    /// <param name="bufferID">The buffer holding the group counts, e.g. written by a culling pass.</param>
+    /// <param name="offset">The byte offset of the three GLuint group counts in the buffer.</param>
+    void DispatchIndirect (GLuint bufferID, GLintptr offset) const;
+
+    /// <summary>
+    /// Makes shader writes visible to the operations named by the glMemoryBarrier bits.
+    /// </summary>
+    static void Barrier (GLbitfield barriers);
+
+    /// <summary>
+    /// Makes shader writes visible to later shader storage buffer reads.
+    /// </summary>
+    static void StorageBarrier ();
+
+    /// <summary>
+    /// Makes shader writes visible to later image loads and texture fetches.
+    /// </summary>
+    static void ImageBarrier ();
+
+    /// <summary>
+    /// Makes shader writes visible to later vertex attribute and index fetches, e.g. particles written by a compute pass.
+    /// </summary>
+    static void VertexBarrier ();
+
+    /// <summary>
+    /// Makes shader writes visible to later indirect draw and dispatch commands.
+    /// </summary>
+    static void CommandBarrier ();
+
+#pragma endregion
+
+    /// <summary>
+    /// Returns how many UseProgram calls on this thread were issued to GL and how many were skipped as redundant.
+    /// </summary>
+    static BindStats GetBindStats ();
+
+    /// <summary>
+    /// Resets the bind counters of this thread to zero.
+    /// </summary>
+    static void ResetBindStats ();
+};
+
+template <typename T>
+void ShaderProgram::BindStorageBuffer (const char* blockName, const StorageBuffer<T>& buffer) const
+{
+    const BlockInfo* block = FindStorageBlock (blockName);
+
+    if (block)
+        buffer.BindTo (block->binding);
+}
+
+/// <summary>
+/// A shader program whose stages have been submitted to the driver but whose compile and link results have not been collected yet.
+/// </summary>
+class PendingShaderProgram
+{
+private:
+    std::unique_ptr<ShaderProgram> program;
+
+    explicit PendingShaderProgram (std::unique_ptr<ShaderProgram> program);
+
+    friend class ShaderProgram;
+
+public:
+    /// <summary>
+    /// Returns whether the driver has finished compiling and linking the program, without blocking.
+    /// Uses GL_COMPLETION_STATUS_KHR; without parallel shader compile support this is always true and Wait does the work.
+    /// </summary>
+    bool IsReady () const;
+
+    /// <summary>
+    /// Waits for the program to compile and link, checks the results and returns the program.
+    /// Exits on a compile or link error, like the synchronous factory constructors. Returns nullptr if called again.
+    /// </summary>
+    std::unique_ptr<ShaderProgram> Wait ();
 };
+
+template <typename T>
+UniformHandle<T> ShaderProgram::GetUniform (const char* uniformName) const
+{
+    UniformHandle<T> handle;
+    UniformInfo uniform;
+
+    if (!ResolveUniform (uniformName, uniform))
+        return handle;
+
+    if (!UniformTraits<T>::Accepts (uniform.type))
+        ReportUniformTypeMismatch (uniformName, uniform.type, UniformTraits<T>::glslType);
+
+    handle.location = uniform.location;
+    handle.type = uniform.type;
+    handle.size = uniform.size;
+    handle.generation = generation;
+
+    const UniformInfo* base = FindUniform (uniformName);
+
+    if (base)
+        handle.index = static_cast<GLint> (base - uniforms.data ());
+    else
+    {
+        //An array element; the table holds the array under its base name
+        base = FindUniform (std::string (uniformName, std::strchr (uniformName, '[')).c_str ());
+        handle.index = static_cast<GLint> (base - uniforms.data ());
+        handle.element = base->size - uniform.size;
+    }
+
+    return handle;
+}
+
+template <typename T>
+void ShaderProgram::Set (const UniformHandle<T>& uniform, const T& value) const
+{
+    //The handle's index and location describe the program before a reload
+    if (uniform.generation != generation)
+    {
+        StoreStale (uniform.generation, uniform.index, uniform.element, 1, &value);
+        return;
+    }
+
+    Store (uniform.index, uniform.location, uniform.element, 1, &value);
+}
+
+template <typename T>
+void ShaderProgram::Set (const UniformHandle<T>& uniform, const T* values, GLsizei count) const
+{
+    if (uniform.generation != generation)
+    {
+        StoreStale (uniform.generation, uniform.index, uniform.element, count, values);
+        return;
+    }
+
+    Store (uniform.index, uniform.location, uniform.element, count, values);
+}
+
+template <typename T>
+void ShaderProgram::StoreStale (std::uint32_t handleGeneration, GLint index, GLint element, GLsizei count, const T* data) const
+{
+    index = RemapStaleIndex (handleGeneration, index);
+
+    if (index < 0 || element >= uniforms[index].size || !UniformTraits<T>::Accepts (uniforms[index].type))
+    {
+        ReportStaleWrite ();
+        return;
+    }
+
+    Store (index, ElementLocation (index, element), element, count, data);
+}
+
+template <typename T>
+void ShaderProgram::Store (GLint index, GLint location, GLint element, GLsizei count, const T* data) const
+{
+    if (UniformTrace::IsCapturing () && index >= 0)
+        UniformTrace::RecordWrite (programName, uniforms[index].name, UniformTraits<T>::glslType, element, count, data, count * sizeof (T));
+
+    //GL ignores elements past the end of the array, so the shadow only needs to track the ones that exist
+    if (index >= 0 && element + count > uniforms[index].size)
+        count = uniforms[index].size - element;
+
+    if (count <= 0)
+        return;
+
+    if (index < 0 || shadows[index].elementSize != sizeof (T))
+    {
+        //Nothing to compare against; pass the write through
+        cacheStats.misses++;
+        Upload (location, count, data);
+        return;
+    }
+
+    UniformShadow& shadow = shadows[index];
+    unsigned char* cached = shadowValues.data () + shadow.offset + element * sizeof (T);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*> (data);
+
+    auto differs = [&] (GLsizei i)
+    {
+        return element + i >= shadow.knownCount || std::memcmp (cached + i * sizeof (T), bytes + i * sizeof (T), sizeof (T)) != 0;
+    };
+
+    GLsizei first = 0;
+
+    while (first < count && !differs (first))
+        first++;
+
+    if (first == count)
+    {
+        cacheStats.hits++;
+        return;
+    }
+
+    GLsizei last = count - 1;
+
+    while (!differs (last))
+        last--;
+
+    std::memcpy (cached + first * sizeof (T), bytes + first * sizeof (T), (last - first + 1) * sizeof (T));
+
+    if (element <= shadow.knownCount)
+        shadow.knownCount = std::max (shadow.knownCount, element + count);
+
+    cacheStats.misses++;
+
+    //Only the changed elements reach GL, starting at the location of the first of them
+    Upload (ElementLocation (index, element + first), last - first + 1, data + first);
+}
+
+template <typename T>
+void ShaderProgram::Upload (GLint location, GLsizei count, const T* data) const
+{
+    if (ShaderProfiler::IsEnabled ())
+        ShaderProfiler::RecordUniformWrite (programName, UniformTraits<T>::glslType, count * sizeof (T));
+
+    switch (uniformWriteMode)
+    {
+    case UniformWriteMode::DirectStateAccess:
+        UniformTraits<T>::ProgramUpload (programID, location, count, data);
+        break;
+    case UniformWriteMode::BindAndSet:
+        if (boundProgramID == programID)
+        {
+            UniformTraits<T>::Upload (location, count, data);
+            break;
+        }
+
+        //Switch only for the write, so the next draw uses the same program as before; binding 0 brings back a bound pipeline
+        GL ().UseProgram (programID);
+        UniformTraits<T>::Upload (location, count, data);
+        GL ().UseProgram (boundProgramID);
+        break;
+    default:
+        UniformTraits<T>::Upload (location, count, data);
+        break;
+    }
+}
+
+template <typename T>
+void ShaderProgram::StoreByName (const std::string& uniformName, GLsizei count, const T* data, GLint firstElement) const
+{
+    const UniformInfo* uniform = FindUniform (uniformName.c_str ());
+
+    //A write to an element by name, e.g. "lights[3]", goes to the shadow of the base array so later array writes compare against it
+    if (!uniform)
+    {
+        GLint element;
+        uniform = FindArrayElement (uniformName.c_str (), element);
+
+        if (uniform)
+            firstElement += element;
+    }
+
+    if (!uniform)
+    {
+        //Writes by index are captured in Store; these have no index, so they are captured under the name they were made with
+        if (UniformTrace::IsCapturing ())
+            UniformTrace::RecordWrite (programName, uniformName, UniformTraits<T>::glslType, firstElement, count, data, count * sizeof (T));
+
+        Store (-1, GetUniformLocation (firstElement == 0 ? uniformName : uniformName + "[" + std::to_string (firstElement) + "]"), 0, count, data);
+    }
+    else if (firstElement >= 0 && firstElement < uniform->size)
+    {
+        GLint index = static_cast<GLint> (uniform - uniforms.data ());
+        Store (index, ElementLocation (index, firstElement), firstElement, count, data);
+    }
+}
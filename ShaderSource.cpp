@@ -0,0 +1,350 @@
+#include "ShaderSource.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+#include "ShaderBundle.h"
+#include "SourceFile.h"
+#include "SourceHash.h"
+
+/// <summary>
+/// The parsed contents of one file: runs of text, and the include directives between them.
+/// </summary>
+struct ShaderSource::Fragment
+{
+    struct Piece
+    {
+        size_t offset;
+        size_t length;
+        // The resolved path of the included file, or empty for a run of text
+        std::string include;
+        // The line of the include directive, counting from 1
+        size_t line;
+    };
+
+    // The contents, pointing into text, or into the mapping of the bundle the file was packed in
+    const char* data;
+    size_t size;
+    std::string text;
+    std::shared_ptr<const ShaderBundle> bundle;
+    std::vector<Piece> pieces;
+};
+
+static std::unordered_map<std::string, std::shared_ptr<const ShaderSource::Fragment>>& CachedFragments ()
+{
+    static std::unordered_map<std::string, std::shared_ptr<const ShaderSource::Fragment>> cachedFragments;
+    return cachedFragments;
+}
+
+// Returns the path named by an #include "file" line, or an empty string if the line is not an include directive
+static std::string ParseInclude (const char* line, const char* end)
+{
+    auto skipSpace = [end] (const char* c)
+    {
+        while (c < end && (*c == ' ' || *c == '\t'))
+            c++;
+
+        return c;
+    };
+
+    const char* c = skipSpace (line);
+
+    if (c == end || *c != '#')
+        return std::string ();
+
+    c = skipSpace (c + 1);
+
+    if (end - c < 7 || std::string (c, 7) != "include")
+        return std::string ();
+
+    c = skipSpace (c + 7);
+
+    if (c == end || *c != '"')
+        return std::string ();
+
+    const char* close = std::find (c + 1, end, '"');
+
+    if (close == end)
+        return std::string ();
+
+    return std::string (c + 1, close);
+}
+
+//Resolved paths are normalized, so a file reached through different relative paths is cached and included once
+static std::string ResolveIncludePath (const std::string& includingFile, const std::string& include)
+{
+    if (!include.empty () && (include[0] == '/' || include[0] == '\\' || include.find (':') != std::string::npos))
+        return ShaderSource::NormalizePath (include);
+
+    size_t separator = includingFile.find_last_of ("/\\");
+
+    if (separator == std::string::npos)
+        return ShaderSource::NormalizePath (include);
+
+    return ShaderSource::NormalizePath (includingFile.substr (0, separator + 1) + include);
+}
+
+static std::shared_ptr<const ShaderSource::Fragment> LoadFragment (const std::string& filename)
+{
+    auto& cachedFragments = CachedFragments ();
+    auto it = cachedFragments.find (filename);
+
+    if (it != cachedFragments.end ())
+        return it->second;
+
+    std::shared_ptr<ShaderSource::Fragment> fragment = std::make_shared<ShaderSource::Fragment> ();
+    const std::shared_ptr<const ShaderBundle>& bundle = ShaderBundle::GetMounted ();
+
+    //Files in the mounted bundle are used in place, keeping the mapping alive for as long as the fragment is cached
+    if (bundle && bundle->Find (ShaderBundle::EntryKind::File, filename, fragment->data, fragment->size))
+        fragment->bundle = bundle;
+    else
+    {
+        SourceFile file (filename);
+
+        if (!file.IsOpen ())
+            return nullptr;
+
+        fragment->text.assign (file.GetData (), file.GetSize ());
+        fragment->data = fragment->text.data ();
+        fragment->size = fragment->text.size ();
+    }
+
+    const char* text = fragment->data;
+    size_t size = fragment->size;
+    size_t runStart = 0;
+    size_t lineStart = 0;
+    size_t lineNumber = 1;
+
+    while (lineStart < size)
+    {
+        const char* newline = static_cast<const char*> (std::memchr (text + lineStart, '\n', size - lineStart));
+        size_t lineEnd = newline ? newline - text : size;
+        size_t nextLine = newline ? lineEnd + 1 : size;
+
+        std::string include = ParseInclude (text + lineStart, text + lineEnd);
+
+        if (!include.empty ())
+        {
+            if (lineStart > runStart)
+                fragment->pieces.push_back ({ runStart, lineStart - runStart, std::string (), 0 });
+
+            fragment->pieces.push_back ({ 0, 0, ResolveIncludePath (filename, include), lineNumber });
+            runStart = nextLine;
+        }
+
+        lineStart = nextLine;
+        lineNumber++;
+    }
+
+    if (size > runStart)
+        fragment->pieces.push_back ({ runStart, size - runStart, std::string (), 0 });
+
+    cachedFragments.emplace (filename, fragment);
+
+    return fragment;
+}
+
+ShaderSource::ShaderSource (const std::string& filename, const std::string& defines)
+    : complete (true)
+{
+    Append (NormalizePath (filename), std::string ());
+
+    if (!defines.empty ())
+    {
+        preamble.reset (new std::string (defines));
+        InsertPreamble ();
+    }
+}
+
+void ShaderSource::InsertPreamble ()
+{
+    //#version must stay the first directive, so the defines go on the line after it
+    size_t index = 0;
+    size_t split = 0;
+    size_t linesBefore = 0;
+
+    for (; index < strings.size (); index++)
+    {
+        const GLchar* begin = strings[index];
+        const GLchar* end = begin + lengths[index];
+        const GLchar* version = std::search (begin, end, "#version", "#version" + 8);
+
+        if (version == end)
+        {
+            linesBefore += std::count (begin, end, '\n');
+            continue;
+        }
+
+        const GLchar* lineEnd = std::find (version, end, '\n');
+        split = (lineEnd == end ? lineEnd : lineEnd + 1) - begin;
+        linesBefore += std::count (begin, begin + split, '\n');
+        break;
+    }
+
+    std::string text = *preamble;
+
+    if (index == strings.size ())
+        linesBefore = 0;
+    else if (strings[index][split - 1] != '\n')
+        text.insert (0, "\n");
+
+    //Keep compile errors pointing at the lines of the file rather than the lines after the defines
+    text += "#line " + std::to_string (linesBefore + 1) + "\n";
+    preamble.reset (new std::string (std::move (text)));
+
+    if (index == strings.size ())
+    {
+        strings.insert (strings.begin (), preamble->data ());
+        lengths.insert (lengths.begin (), static_cast<GLint> (preamble->size ()));
+        return;
+    }
+
+    const GLchar* rest = strings[index] + split;
+    GLint restLength = lengths[index] - static_cast<GLint> (split);
+    lengths[index] = static_cast<GLint> (split);
+
+    strings.insert (strings.begin () + index + 1, { preamble->data (), rest });
+    lengths.insert (lengths.begin () + index + 1, { static_cast<GLint> (preamble->size ()), restLength });
+}
+
+void ShaderSource::Append (const std::string& filename, const std::string& includedFrom)
+{
+    //Include each file once, which also breaks include cycles
+    if (std::find (files.begin (), files.end (), filename) != files.end ())
+        return;
+
+    std::shared_ptr<const Fragment> fragment = LoadFragment (filename);
+
+    if (!fragment)
+    {
+        std::cerr << "Could not open shader file: " << filename;
+
+        if (!includedFrom.empty ())
+            std::cerr << " (included from " << includedFrom << ")";
+
+        std::cerr << "\n";
+        complete = false;
+        return;
+    }
+
+    //The file's index is its source string number, so compile errors name the file and its own line numbers
+    size_t fileIndex = files.size ();
+    files.push_back (filename);
+    fragments.push_back (fragment);
+
+    if (!includedFrom.empty ())
+        AppendLineDirective (1, fileIndex);
+
+    for (const Fragment::Piece& piece : fragment->pieces)
+    {
+        if (!piece.include.empty ())
+        {
+            //The directive's line is dropped from the text, so resume on the line after it even if nothing was included
+            Append (piece.include, filename);
+            AppendLineDirective (piece.line + 1, fileIndex);
+            continue;
+        }
+
+        strings.push_back (fragment->data + piece.offset);
+        lengths.push_back (static_cast<GLint> (piece.length));
+    }
+
+    //Keep the next piece on a fresh line when an included file does not end with a newline
+    if (!includedFrom.empty () && fragment->size > 0 && fragment->data[fragment->size - 1] != '\n')
+    {
+        strings.push_back ("\n");
+        lengths.push_back (1);
+    }
+}
+
+void ShaderSource::AppendLineDirective (size_t line, size_t fileIndex)
+{
+    lineDirectives.emplace_back (new std::string ("#line " + std::to_string (line) + " " + std::to_string (fileIndex) + "\n"));
+    strings.push_back (lineDirectives.back ()->data ());
+    lengths.push_back (static_cast<GLint> (lineDirectives.back ()->size ()));
+}
+
+bool ShaderSource::IsComplete () const
+{
+    return complete;
+}
+
+GLsizei ShaderSource::GetStringCount () const
+{
+    return static_cast<GLsizei> (strings.size ());
+}
+
+const GLchar* const* ShaderSource::GetStrings () const
+{
+    return strings.data ();
+}
+
+const GLint* ShaderSource::GetLengths () const
+{
+    return lengths.data ();
+}
+
+const std::vector<std::string>& ShaderSource::GetFiles () const
+{
+    return files;
+}
+
+std::uint64_t ShaderSource::Hash (std::uint64_t hash) const
+{
+    for (size_t i = 0; i < strings.size (); i++)
+        hash = HashBytes (strings[i], lengths[i], hash);
+
+    return HashBytes ("", 1, hash);
+}
+
+void ShaderSource::InvalidateFile (const std::string& filename)
+{
+    CachedFragments ().erase (NormalizePath (filename));
+}
+
+void ShaderSource::InvalidateAllFiles ()
+{
+    CachedFragments ().clear ();
+}
+
+std::string ShaderSource::NormalizePath (const std::string& path)
+{
+    std::vector<std::string> segments;
+    bool absolute = !path.empty () && (path[0] == '/' || path[0] == '\\');
+    size_t start = 0;
+
+    while (start <= path.size ())
+    {
+        size_t end = path.find_first_of ("/\\", start);
+
+        if (end == std::string::npos)
+            end = path.size ();
+
+        std::string segment = path.substr (start, end - start);
+        start = end + 1;
+
+        if (segment.empty () || segment == ".")
+            continue;
+
+        //Leading ".." segments of a relative path stay, since they point outside the directory the paths are relative to
+        if (segment == ".." && !segments.empty () && segments.back () != "..")
+            segments.pop_back ();
+        else if (segment != ".." || !absolute)
+            segments.push_back (std::move (segment));
+    }
+
+    std::string normalized = absolute ? "/" : "";
+
+    for (size_t i = 0; i < segments.size (); i++)
+    {
+        if (i > 0)
+            normalized += '/';
+
+        normalized += segments[i];
+    }
+
+    return normalized;
+}
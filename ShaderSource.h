@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+/// <summary>
+/// The source of one shader stage with its #include "file" directives resolved.
+/// Every file is parsed once into a cached fragment shared by all stages that include it, and the resolved source is
+/// a list of strings pointing into those fragments, passed to glShaderSource without concatenating them.
+/// Include paths are relative to the including file, and each file is included at most once per stage. Paths are normalized
+/// first, so the same file reached as "lighting/../common.glsl" and "common.glsl" is read, cached and included as one.
+/// While a ShaderBundle is mounted, files it holds are read from it rather than from disk.
+/// </summary>
+class ShaderSource
+{
+public:
+    struct Fragment;
+
+private:
+    std::vector<std::shared_ptr<const Fragment>> fragments;
+    std::vector<const GLchar*> strings;
+    std::vector<GLint> lengths;
+    std::vector<std::string> files;
+    // Defines injected after the #version line; held by pointer so the strings stay valid if the source is moved
+    std::unique_ptr<const std::string> preamble;
+    // #line directives around each include, held by pointer for the same reason
+    std::vector<std::unique_ptr<const std::string>> lineDirectives;
+    bool complete;
+
+    void Append (const std::string& filename, const std::string& includedFrom);
+    void AppendLineDirective (size_t line, size_t fileIndex);
+    void InsertPreamble ();
+
+public:
+    /// <summary>
+    /// Resolves the source of a stage. If the file or one of its includes cannot be opened, reports it and leaves the source incomplete.
+    /// </summary>
+    /// <param name="filename">The shader file.</param>
+    /// <param name="defines">Lines such as "#define SKINNING\n" to inject after the #version line, or an empty string.</param>
+    explicit ShaderSource (const std::string& filename, const std::string& defines = std::string ());
+
+    /// <summary>
+    /// Returns whether the file and all of its includes could be opened.
+    /// </summary>
+    bool IsComplete () const;
+
+    /// <summary>
+    /// Returns the number of strings making up the resolved source.
+    /// </summary>
+    GLsizei GetStringCount () const;
+
+    /// <summary>
+    /// Returns the strings making up the resolved source, as passed to glShaderSource. They are not null-terminated.
+    /// </summary>
+    const GLchar* const* GetStrings () const;
+
+    /// <summary>
+    /// Returns the length of each string.
+    /// </summary>
+    const GLint* GetLengths () const;
+
+    /// <summary>
+    /// Returns the shader file and every file it includes, directly or indirectly. A file's index is the source string number
+    /// the compiler reports its errors under, and the line numbers are the file's own.
+    /// </summary>
+    const std::vector<std::string>& GetFiles () const;
+
+    /// <summary>
+    /// Extends a hash with the resolved source text.
+    /// </summary>
+    /// <param name="hash">The hash to extend.</param>
+    std::uint64_t Hash (std::uint64_t hash) const;
+
+    /// <summary>
+    /// Drops the cached fragment of a file, so the next stage that uses the file reads it again.
+    /// </summary>
+    /// <param name="filename">The file that changed.</param>
+    static void InvalidateFile (const std::string& filename);
+
+    /// <summary>
+    /// Drops the cached fragments of every file, as when the files are to be resolved through a different bundle.
+    /// </summary>
+    static void InvalidateAllFiles ();
+
+    /// <summary>
+    /// Folds a path into the form files are cached, reported and looked up in a bundle under: "\" becomes "/", and "." and ".."
+    /// segments are resolved.
+    /// </summary>
+    /// <param name="path">The path to fold.</param>
+    static std::string NormalizePath (const std::string& path);
+};
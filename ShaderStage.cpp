@@ -0,0 +1,71 @@
+#include "ShaderStage.h"
+
+#include <map>
+#include <utility>
+
+#include "GLDispatch.h"
+
+ShaderStage::Stats ShaderStage::stats = {};
+
+// Live stages by (type, source hash). Entries are weak so the cache never keeps a shader object alive by itself.
+static std::map<std::pair<GLenum, std::uint64_t>, std::weak_ptr<ShaderStage>>& LiveStages ()
+{
+    static std::map<std::pair<GLenum, std::uint64_t>, std::weak_ptr<ShaderStage>> liveStages;
+    return liveStages;
+}
+
+ShaderStage::ShaderStage (GLenum type, std::uint64_t key)
+    : shaderID (GL ().CreateShader (type)), type (type), key (key)
+{
+}
+
+ShaderStage::~ShaderStage ()
+{
+    auto& liveStages = LiveStages ();
+    auto it = liveStages.find ({ type, key });
+
+    if (it != liveStages.end () && it->second.expired ())
+        liveStages.erase (it);
+
+    GL ().DeleteShader (shaderID);
+}
+
+std::shared_ptr<ShaderStage> ShaderStage::Find (GLenum type, std::uint64_t sourceHash)
+{
+    auto& liveStages = LiveStages ();
+    auto it = liveStages.find ({ type, sourceHash });
+
+    if (it == liveStages.end ())
+        return nullptr;
+
+    std::shared_ptr<ShaderStage> stage = it->second.lock ();
+
+    if (stage)
+        stats.reused++;
+
+    return stage;
+}
+
+std::shared_ptr<ShaderStage> ShaderStage::Create (GLenum type, std::uint64_t sourceHash)
+{
+    std::shared_ptr<ShaderStage> stage (new ShaderStage (type, sourceHash));
+    LiveStages ()[{ type, sourceHash }] = stage;
+    stats.compiled++;
+
+    return stage;
+}
+
+ShaderStage::Stats ShaderStage::GetStats ()
+{
+    return stats;
+}
+
+GLuint ShaderStage::GetShaderID () const
+{
+    return shaderID;
+}
+
+GLenum ShaderStage::GetType () const
+{
+    return type;
+}
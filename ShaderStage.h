@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <GL/glew.h>
+
+/// <summary>
+/// A shader object shared by every pending program that uses the same source for the same stage.
+/// Stages are keyed by stage type and source content hash, and the shader object is deleted when the last program holding it has been linked.
+/// Stages must only be used on the GL thread.
+/// </summary>
+class ShaderStage
+{
+public:
+    /// <summary>
+    /// Counts stages compiled from source and stages handed out again from the cache.
+    /// </summary>
+    struct Stats
+    {
+        std::uint64_t compiled;
+        std::uint64_t reused;
+    };
+
+private:
+    GLuint shaderID;
+    GLenum type;
+    std::uint64_t key;
+
+    static Stats stats;
+
+    ShaderStage (GLenum type, std::uint64_t key);
+
+public:
+    ~ShaderStage ();
+
+    ShaderStage (const ShaderStage&) = delete;
+    ShaderStage& operator= (const ShaderStage&) = delete;
+
+    /// <summary>
+    /// Returns the live stage with the given type and source hash, or nullptr if no pending program holds one.
+    /// </summary>
+    /// <param name="type">The stage type, e.g. GL_VERTEX_SHADER.</param>
+    /// <param name="sourceHash">The hash of the stage source.</param>
+    static std::shared_ptr<ShaderStage> Find (GLenum type, std::uint64_t sourceHash);
+
+    /// <summary>
+    /// Creates an empty shader object for a stage and makes it findable until the last reference to it is released.
+    /// </summary>
+    /// <param name="type">The stage type, e.g. GL_VERTEX_SHADER.</param>
+    /// <param name="sourceHash">The hash of the stage source.</param>
+    static std::shared_ptr<ShaderStage> Create (GLenum type, std::uint64_t sourceHash);
+
+    /// <summary>
+    /// Returns how many stages were compiled and how many were shared.
+    /// </summary>
+    static Stats GetStats ();
+
+    /// <summary>
+    /// Returns the GL name of the shader object.
+    /// </summary>
+    GLuint GetShaderID () const;
+
+    /// <summary>
+    /// Returns the stage type, e.g. GL_VERTEX_SHADER.
+    /// </summary>
+    GLenum GetType () const;
+};
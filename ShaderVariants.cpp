@@ -0,0 +1,181 @@
+#include "ShaderVariants.h"
+
+#include <algorithm>
+#include <iostream>
+
+std::unique_ptr<ShaderVariants> ShaderVariants::Create (const std::string& programName, const std::vector<std::string>& features)
+{
+    return CreateWithNames (programName, programName + ".vert", "", programName + ".frag", features);
+}
+
+std::unique_ptr<ShaderVariants> ShaderVariants::CreateWithGeometry (const std::string& programName, const std::vector<std::string>& features)
+{
+    return CreateWithNames (programName, programName + ".vert", programName + ".geom", programName + ".frag", features);
+}
+
+std::unique_ptr<ShaderVariants> ShaderVariants::CreateWithNames (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename, const std::vector<std::string>& features)
+{
+    if (features.size () > 32)
+    {
+        std::cerr << "Shader program " << programName << " has " << features.size () << " features, but a feature mask holds at most 32\n";
+        exit (EXIT_FAILURE);
+    }
+
+    std::unique_ptr<ShaderVariants> variants (new ShaderVariants ());
+
+    variants->programName = programName;
+    variants->vertexFilename = vertexFilename;
+    variants->geometryFilename = geometryFilename;
+    variants->fragmentFilename = fragmentFilename;
+    variants->features = features;
+
+    return variants;
+}
+
+void ShaderVariants::CheckMask (std::uint32_t mask) const
+{
+    if (features.size () < 32 && (mask >> features.size ()) != 0)
+    {
+        std::cerr << "Feature mask " << mask << " enables features that shader program " << programName << " does not have\n";
+        exit (EXIT_FAILURE);
+    }
+}
+
+std::string ShaderVariants::GetVariantName (std::uint32_t mask) const
+{
+    std::string name = programName + "[";
+
+    for (size_t i = 0; i < features.size (); i++)
+    {
+        if (mask & (1u << i))
+        {
+            name += name.back () == '[' ? "" : " ";
+            name += features[i];
+        }
+    }
+
+    return name + "]";
+}
+
+std::unique_ptr<ShaderProgram> ShaderVariants::Submit (std::uint32_t mask) const
+{
+    return ShaderProgram::Submit (GetVariantName (mask), vertexFilename, geometryFilename, fragmentFilename, GetDefines (mask));
+}
+
+ShaderProgram& ShaderVariants::Collect (std::uint32_t mask, std::unique_ptr<ShaderProgram> program)
+{
+    if (!program->CheckLinkStatus ())
+        exit (EXIT_FAILURE);
+
+    stats.compiled++;
+
+    return *(variants[mask] = std::move (program));
+}
+
+ShaderProgram& ShaderVariants::Get (std::uint32_t mask)
+{
+    auto it = variants.find (mask);
+
+    if (it != variants.end ())
+    {
+        stats.hits++;
+        return *it->second;
+    }
+
+    CheckMask (mask);
+
+    auto pending = pendingVariants.find (mask);
+
+    if (pending != pendingVariants.end ())
+    {
+        std::unique_ptr<ShaderProgram> program = std::move (pending->second);
+        pendingVariants.erase (pending);
+        return Collect (mask, std::move (program));
+    }
+
+    return Collect (mask, Submit (mask));
+}
+
+void ShaderVariants::Precompile (const std::vector<std::uint32_t>& masks)
+{
+    for (std::uint32_t mask : masks)
+    {
+        CheckMask (mask);
+
+        if (variants.count (mask) || pendingVariants.count (mask))
+            continue;
+
+        pendingVariants.emplace (mask, Submit (mask));
+    }
+}
+
+size_t ShaderVariants::Poll ()
+{
+    size_t collected = 0;
+
+    for (auto it = pendingVariants.begin (); it != pendingVariants.end ();)
+    {
+        if (!it->second->IsLinkComplete ())
+        {
+            ++it;
+            continue;
+        }
+
+        std::uint32_t mask = it->first;
+        std::unique_ptr<ShaderProgram> program = std::move (it->second);
+        it = pendingVariants.erase (it);
+
+        Collect (mask, std::move (program));
+        collected++;
+    }
+
+    return collected;
+}
+
+std::uint32_t ShaderVariants::GetMask (const std::vector<std::string>& enabledFeatures) const
+{
+    std::uint32_t mask = 0;
+
+    for (const std::string& feature : enabledFeatures)
+    {
+        auto it = std::find (features.begin (), features.end (), feature);
+
+        if (it == features.end ())
+        {
+            std::cerr << "Shader program " << programName << " has no feature named " << feature << "\n";
+            exit (EXIT_FAILURE);
+        }
+
+        mask |= 1u << (it - features.begin ());
+    }
+
+    return mask;
+}
+
+std::string ShaderVariants::GetDefines (std::uint32_t mask) const
+{
+    std::string defines;
+
+    for (size_t i = 0; i < features.size (); i++)
+    {
+        if (mask & (1u << i))
+            defines += "#define " + features[i] + "\n";
+    }
+
+    return defines;
+}
+
+bool ShaderVariants::IsCompiled (std::uint32_t mask) const
+{
+    return variants.count (mask) != 0;
+}
+
+size_t ShaderVariants::GetVariantCount () const
+{
+    return variants.size ();
+}
+
+ShaderVariants::VariantStats ShaderVariants::GetStats () const
+{
+    return stats;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ShaderProgram.h"
+
+/// <summary>
+/// The variants of one shader program that differ only in which feature #defines are set, e.g. SHADOWS, SKINNING or FOG.
+/// Bit i of a feature mask enables the i-th feature. A variant is compiled the first time it is requested and kept for
+/// later requests, so compile time and memory grow with the variants actually used rather than with every combination.
+/// </summary>
+class ShaderVariants
+{
+public:
+    /// <summary>
+    /// Counts Get calls served by an already built variant (hits) and variants built (compiled).
+    /// </summary>
+    struct VariantStats
+    {
+        std::uint64_t hits;
+        std::uint64_t compiled;
+    };
+
+private:
+    std::string programName;
+    std::string vertexFilename;
+    std::string geometryFilename;
+    std::string fragmentFilename;
+    std::vector<std::string> features;
+
+    std::unordered_map<std::uint32_t, std::unique_ptr<ShaderProgram>> variants;
+    // Variants submitted by Precompile whose compile and link results have not been collected yet
+    std::unordered_map<std::uint32_t, std::unique_ptr<ShaderProgram>> pendingVariants;
+
+    VariantStats stats = {};
+
+    ShaderVariants () = default;
+
+    void CheckMask (std::uint32_t mask) const;
+    std::string GetVariantName (std::uint32_t mask) const;
+    std::unique_ptr<ShaderProgram> Submit (std::uint32_t mask) const;
+    ShaderProgram& Collect (std::uint32_t mask, std::unique_ptr<ShaderProgram> program);
+
+public:
+    /// <summary>
+    /// Creates the variants of a program with vertex and fragment shaders named programName + ".vert" and programName + ".frag".
+    /// Nothing is compiled until a variant is requested.
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    /// <param name="features">The names of the features, defined as macros in the variants that enable them. At most 32.</param>
+    static std::unique_ptr<ShaderVariants> Create (const std::string& programName, const std::vector<std::string>& features);
+
+    /// <summary>
+    /// Creates the variants of a program with vertex, geometry and fragment shaders named programName + ".vert", programName + ".geom" and programName + ".frag".
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    /// <param name="features">The names of the features, defined as macros in the variants that enable them. At most 32.</param>
+    static std::unique_ptr<ShaderVariants> CreateWithGeometry (const std::string& programName, const std::vector<std::string>& features);
+
+    /// <summary>
+    /// Creates the variants of a program with custom filenames.
+    /// </summary>
+    /// <param name="programName">The name of the program.</param>
+    /// <param name="vertexFilename">The vertex shader file.</param>
+    /// <param name="geometryFilename">The geometry shader file, or an empty string for none.</param>
+    /// <param name="fragmentFilename">The fragment shader file.</param>
+    /// <param name="features">The names of the features, defined as macros in the variants that enable them. At most 32.</param>
+    static std::unique_ptr<ShaderVariants> CreateWithNames (const std::string& programName, const std::string& vertexFilename, const std::string& geometryFilename, const std::string& fragmentFilename, const std::vector<std::string>& features);
+
+    /// <summary>
+    /// Returns the variant with the given features enabled, compiling it if it has not been requested before.
+    /// Exits on a compile or link error, or if the mask has bits beyond the last feature.
+    /// </summary>
+    /// <param name="mask">The enabled features, bit i for the i-th feature.</param>
+    ShaderProgram& Get (std::uint32_t mask);
+
+    /// <summary>
+    /// Submits variants known to be needed soon to the driver without waiting for them. With parallel shader compilation,
+    /// the driver builds them on its own threads; a later Get of a submitted variant only collects the result.
+    /// </summary>
+    /// <param name="masks">The variants to build.</param>
+    void Precompile (const std::vector<std::uint32_t>& masks);
+
+    /// <summary>
+    /// Collects the precompiled variants the driver has finished, without blocking. Exits on a compile or link error.
+    /// </summary>
+    /// <returns>The number of variants collected.</returns>
+    size_t Poll ();
+
+    /// <summary>
+    /// Returns the mask enabling the named features. Exits if a name is not one of the features.
+    /// </summary>
+    /// <param name="enabledFeatures">The names of the features to enable.</param>
+    std::uint32_t GetMask (const std::vector<std::string>& enabledFeatures) const;
+
+    /// <summary>
+    /// Returns the #define lines injected into the variant with the given mask.
+    /// </summary>
+    /// <param name="mask">The enabled features, bit i for the i-th feature.</param>
+    std::string GetDefines (std::uint32_t mask) const;
+
+    /// <summary>
+    /// Returns whether the variant with the given mask has been built and collected.
+    /// </summary>
+    /// <param name="mask">The enabled features, bit i for the i-th feature.</param>
+    bool IsCompiled (std::uint32_t mask) const;
+
+    /// <summary>
+    /// Returns the number of variants built and collected so far.
+    /// </summary>
+    size_t GetVariantCount () const;
+
+    /// <summary>
+    /// Returns how many requests were served by a built variant and how many variants were built.
+    /// </summary>
+    VariantStats GetStats () const;
+};
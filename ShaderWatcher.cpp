@@ -0,0 +1,199 @@
+#include "ShaderWatcher.h"
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_set>
+
+#include "ShaderSource.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+ShaderWatcher::ShaderWatcher ()
+    : inotifyDescriptor (-1), watchedVersion (0)
+{
+#ifdef __linux__
+    inotifyDescriptor = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+
+    if (inotifyDescriptor == -1)
+        std::cerr << "Could not start watching shader files; programs can still be reloaded explicitly\n";
+#endif
+
+    ShaderProgram::watcher = this;
+}
+
+ShaderWatcher::~ShaderWatcher ()
+{
+    ShaderProgram::watcher = nullptr;
+
+#ifdef __linux__
+    if (inotifyDescriptor != -1)
+        close (inotifyDescriptor);
+#endif
+}
+
+bool ShaderWatcher::IsWatching () const
+{
+    return inotifyDescriptor != -1;
+}
+
+void ShaderWatcher::WatchSourceFiles ()
+{
+#ifdef __linux__
+    if (inotifyDescriptor == -1 || watchedVersion == ShaderProgram::sourceFilesVersion)
+        return;
+
+    watchedVersion = ShaderProgram::sourceFilesVersion;
+
+    for (const auto& entry : ShaderProgram::dependentPrograms)
+    {
+        //Watch directories rather than files, so editors that save by replacing the file are still seen
+        const std::string& file = entry.first;
+        size_t separator = file.find_last_of ('/');
+        std::string directory = separator == std::string::npos ? std::string () : file.substr (0, separator + 1);
+
+        if (directoryWatches.count (directory))
+            continue;
+
+        int watch = inotify_add_watch (inotifyDescriptor, directory.empty () ? "." : directory.c_str (), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+        if (watch == -1)
+        {
+            std::cerr << "Could not watch shader directory: " << (directory.empty () ? "." : directory) << "\n";
+            continue;
+        }
+
+        directoryWatches[directory] = watch;
+        watchedDirectories[watch].push_back (directory);
+    }
+#endif
+}
+
+std::vector<std::string> ShaderWatcher::ReadChangedFiles ()
+{
+    std::vector<std::string> changedFiles;
+
+#ifdef __linux__
+    if (inotifyDescriptor == -1)
+        return changedFiles;
+
+    alignas (inotify_event) char buffer[4096];
+    ssize_t length;
+
+    while ((length = read (inotifyDescriptor, buffer, sizeof (buffer))) > 0)
+    {
+        for (char* event = buffer; event < buffer + length; )
+        {
+            const inotify_event* notification = reinterpret_cast<const inotify_event*> (event);
+            auto directories = watchedDirectories.find (notification->wd);
+
+            if (notification->len > 0 && directories != watchedDirectories.end ())
+            {
+                for (const std::string& directory : directories->second)
+                    changedFiles.push_back (directory + notification->name);
+            }
+
+            event += sizeof (inotify_event) + notification->len;
+        }
+    }
+#endif
+
+    return changedFiles;
+}
+
+std::vector<ShaderProgram*> ShaderWatcher::Poll ()
+{
+    WatchSourceFiles ();
+
+    std::unordered_set<ShaderProgram*> programsToReload;
+
+    for (const std::string& file : ReadChangedFiles ())
+    {
+        auto dependents = ShaderProgram::dependentPrograms.find (file);
+
+        if (dependents == ShaderProgram::dependentPrograms.end ())
+            continue;
+
+        ShaderSource::InvalidateFile (file);
+
+        for (ShaderProgram* program : dependents->second)
+            programsToReload.insert (program);
+    }
+
+    for (ShaderProgram* program : programsToReload)
+    {
+        //Rebuilt versions are registered as dependents too, but are not reloaded themselves
+        bool isRebuild = std::any_of (pendingReloads.begin (), pendingReloads.end (), [program] (const auto& pending) { return pending.second.get () == program; });
+
+        if (!isRebuild)
+            Reload (program);
+    }
+
+    std::vector<ShaderProgram*> reloadedPrograms;
+
+    for (auto it = pendingReloads.begin (); it != pendingReloads.end (); )
+    {
+        ShaderProgram* program = it->first;
+
+        if (!it->second->IsLinkComplete ())
+        {
+            ++it;
+            continue;
+        }
+
+        //Destroy the rebuild only after it has left the map, since its destructor calls Forget
+        std::unique_ptr<ShaderProgram> finished = std::move (it->second);
+        it = pendingReloads.erase (it);
+
+        if (finished->CheckLinkStatus ())
+        {
+            program->AdoptProgram (*finished);
+            reloadedPrograms.push_back (program);
+        }
+        else
+            std::cerr << "Keeping the previous version of shader: " << program->programName << "\n";
+    }
+
+    return reloadedPrograms;
+}
+
+void ShaderWatcher::Reload (ShaderProgram* program)
+{
+    //SPIR-V programs keep neither their module files nor their specialization constants, so they cannot be rebuilt from here
+    if (program->spirv)
+    {
+        std::cerr << "Cannot reload shader built from SPIR-V: " << program->programName << "\n";
+        return;
+    }
+
+    //A newer change replaces a rebuild that is still in flight
+    Forget (program);
+
+    std::unique_ptr<ShaderProgram> rebuilt = program->singleStageType == GL_NONE
+        ? ShaderProgram::SubmitStages (program->programName, program->vertexFilename, program->geometryFilename, program->fragmentFilename, program->defines)
+        : ShaderProgram::SubmitSingleStage (program->programName, program->singleStageType, *program->FilenameSlot (program->singleStageType), program->separable, program->defines);
+
+    if (!rebuilt)
+    {
+        std::cerr << "Keeping the previous version of shader: " << program->programName << "\n";
+        return;
+    }
+
+    if (!rebuilt->loadedFromBinaryCache)
+        rebuilt->LinkProgram ();
+
+    pendingReloads[program] = std::move (rebuilt);
+}
+
+void ShaderWatcher::Forget (ShaderProgram* program)
+{
+    auto it = pendingReloads.find (program);
+
+    if (it == pendingReloads.end ())
+        return;
+
+    std::unique_ptr<ShaderProgram> abandoned = std::move (it->second);
+    pendingReloads.erase (it);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ShaderProgram.h"
+
+/// <summary>
+/// Watches the files of every live shader program and rebuilds the programs whose files change.
+/// Changes are picked up through inotify on Linux; elsewhere programs can be reloaded explicitly with Reload.
+/// A rebuilt program is compiled and linked in the background and swapped into the existing ShaderProgram object only if it links;
+/// on an error the log is reported and the previous version keeps running.
+/// Create the watcher before the programs it should reload, so they keep their compiled stages and a reload only recompiles the stages whose files changed.
+/// Only one watcher may exist at a time, and it must only be used on the GL thread.
+/// </summary>
+class ShaderWatcher
+{
+private:
+    int inotifyDescriptor;
+    std::uint64_t watchedVersion;
+
+    // Directories being watched, as spelled in the programs' filenames, by watch descriptor
+    std::unordered_map<int, std::vector<std::string>> watchedDirectories;
+    std::unordered_map<std::string, int> directoryWatches;
+
+    // Programs being rebuilt, and their rebuilt versions waiting for the driver
+    std::unordered_map<ShaderProgram*, std::unique_ptr<ShaderProgram>> pendingReloads;
+
+    void WatchSourceFiles ();
+    std::vector<std::string> ReadChangedFiles ();
+    void Forget (ShaderProgram* program);
+
+    friend class ShaderProgram;
+
+public:
+    ShaderWatcher ();
+    ~ShaderWatcher ();
+
+    ShaderWatcher (const ShaderWatcher&) = delete;
+    ShaderWatcher& operator= (const ShaderWatcher&) = delete;
+
+    /// <summary>
+    /// Returns whether file changes are detected automatically on this platform.
+    /// </summary>
+    bool IsWatching () const;
+
+    /// <summary>
+    /// Starts rebuilding every program that depends on changed files, and swaps in the rebuilt programs that have finished linking.
+    /// Never blocks on the driver. Call once per frame.
+    /// </summary>
+    /// <returns>The programs that were replaced by this call. Their uniform handles must be obtained again and their uniforms set again.</returns>
+    std::vector<ShaderProgram*> Poll ();
+
+    /// <summary>
+    /// Starts rebuilding a program from its files, as if one of them had changed. The result is swapped in by a later Poll.
+    /// Programs built from SPIR-V are not rebuilt; the call reports that and keeps the program as it is.
+    /// </summary>
+    /// <param name="program">The program to rebuild.</param>
+    void Reload (ShaderProgram* program);
+};
@@ -0,0 +1,136 @@
+#include "SourceFile.h"
+
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceFile::SourceFile (const std::string& filename)
+    : data (""), size (0), open (false), mappedView (nullptr)
+#ifdef _WIN32
+    , fileHandle (INVALID_HANDLE_VALUE), mappingHandle (nullptr)
+#endif
+{
+    open = Map (filename) || Read (filename);
+}
+
+SourceFile::~SourceFile ()
+{
+#ifdef _WIN32
+    if (mappedView)
+        UnmapViewOfFile (mappedView);
+
+    if (mappingHandle)
+        CloseHandle (mappingHandle);
+
+    if (fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle (fileHandle);
+#else
+    if (mappedView)
+        munmap (mappedView, size);
+#endif
+}
+
+bool SourceFile::Map (const std::string& filename)
+{
+#ifdef _WIN32
+    fileHandle = CreateFileA (filename.c_str (), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+
+    if (!GetFileSizeEx (fileHandle, &fileSize))
+        return false;
+
+    //Empty files cannot be mapped, but they are open
+    if (fileSize.QuadPart == 0)
+        return true;
+
+    mappingHandle = CreateFileMappingA (fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (!mappingHandle)
+        return false;
+
+    mappedView = MapViewOfFile (mappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+    if (!mappedView)
+        return false;
+
+    data = static_cast<const char*> (mappedView);
+    size = static_cast<size_t> (fileSize.QuadPart);
+
+    return true;
+#else
+    int descriptor = ::open (filename.c_str (), O_RDONLY);
+
+    if (descriptor == -1)
+        return false;
+
+    struct stat status;
+
+    if (fstat (descriptor, &status) != 0 || !S_ISREG (status.st_mode))
+    {
+        close (descriptor);
+        return false;
+    }
+
+    //Empty files cannot be mapped, but they are open
+    if (status.st_size == 0)
+    {
+        close (descriptor);
+        return true;
+    }
+
+    void* view = mmap (nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close (descriptor);
+
+    if (view == MAP_FAILED)
+        return false;
+
+    mappedView = view;
+    data = static_cast<const char*> (view);
+    size = static_cast<size_t> (status.st_size);
+
+    return true;
+#endif
+}
+
+bool SourceFile::Read (const std::string& filename)
+{
+    std::ifstream stream (filename, std::ios::binary);
+
+    if (!stream.is_open ())
+        return false;
+
+    buffer.assign (std::istreambuf_iterator<char> (stream), std::istreambuf_iterator<char> ());
+    data = buffer.data ();
+    size = buffer.size ();
+
+    return true;
+}
+
+bool SourceFile::IsOpen () const
+{
+    return open;
+}
+
+const char* SourceFile::GetData () const
+{
+    return data;
+}
+
+size_t SourceFile::GetSize () const
+{
+    return size;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// A read-only view of the whole contents of a file, memory-mapped where the platform allows and read into a single buffer otherwise.
+/// </summary>
+class SourceFile
+{
+private:
+    const char* data;
+    size_t size;
+    bool open;
+
+    // Platform mapping handles; unused when the contents were read into buffer instead
+    void* mappedView;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+
+    std::vector<char> buffer;
+
+    bool Map (const std::string& filename);
+    bool Read (const std::string& filename);
+
+public:
+    /// <summary>
+    /// Opens and maps a file.
+    /// </summary>
+    /// <param name="filename">The file to open.</param>
+    explicit SourceFile (const std::string& filename);
+    ~SourceFile ();
+
+    SourceFile (const SourceFile&) = delete;
+    SourceFile& operator= (const SourceFile&) = delete;
+
+    /// <summary>
+    /// Returns whether the file could be opened.
+    /// </summary>
+    bool IsOpen () const;
+
+    /// <summary>
+    /// Returns the contents of the file. The contents are not null-terminated.
+    /// </summary>
+    const char* GetData () const;
+
+    /// <summary>
+    /// Returns the size of the file in bytes.
+    /// </summary>
+    size_t GetSize () const;
+};
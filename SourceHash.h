@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// The FNV-1a offset basis, the seed of an empty hash.
+/// </summary>
+constexpr std::uint64_t SourceHashSeed = 14695981039346656037ull;
+
+/// <summary>
+/// Extends a 64-bit FNV-1a hash with a block of bytes. Used to key caches by shader source content.
+/// </summary>
+/// <param name="data">The bytes to hash.</param>
+/// <param name="length">The number of bytes.</param>
+/// <param name="hash">The hash to extend, or SourceHashSeed to start a new one.</param>
+inline std::uint64_t HashBytes (const void* data, size_t length, std::uint64_t hash = SourceHashSeed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*> (data);
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/// <summary>
+/// Extends a hash with a block of text, followed by a terminator so that consecutive texts cannot run into each other.
+/// </summary>
+/// <param name="text">The text to hash.</param>
+/// <param name="length">The length of the text.</param>
+/// <param name="hash">The hash to extend, or SourceHashSeed to start a new one.</param>
+inline std::uint64_t HashText (const char* text, size_t length, std::uint64_t hash = SourceHashSeed)
+{
+    hash = HashBytes (text, length, hash);
+    return HashBytes ("", 1, hash);
+}
+
+/// <summary>
+/// Extends a hash with a string, followed by a terminator so that consecutive strings cannot run into each other.
+/// </summary>
+/// <param name="text">The string to hash.</param>
+/// <param name="hash">The hash to extend, or SourceHashSeed to start a new one.</param>
+inline std::uint64_t HashString (const std::string& text, std::uint64_t hash = SourceHashSeed)
+{
+    return HashText (text.data (), text.size (), hash);
+}
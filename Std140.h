@@ -0,0 +1,168 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <tuple>
+#include <utility>
+
+#include <GL/glew.h>
+
+#include <glm/matrix.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+/// <summary>
+/// The std140 base alignment and size of a C++ value type, and how to write it into a std140 buffer.
+/// </summary>
+template <typename T>
+struct Std140Traits;
+
+/// <summary>
+/// Scalars and vectors are tightly packed; vec3 is aligned like vec4 but only occupies 12 bytes.
+/// </summary>
+template <typename T, size_t Components>
+struct Std140Vector
+{
+    static constexpr size_t alignment = Components == 1 ? 4 : Components == 2 ? 8 : 16;
+    static constexpr size_t size = 4 * Components;
+
+    static void Write (unsigned char* destination, const T& value)
+    {
+        std::memcpy (destination, &value, size);
+    }
+};
+
+/// <summary>
+/// Matrices are stored as arrays of column vectors, each padded to the size of a vec4, so a mat3 takes 48 bytes.
+/// </summary>
+template <typename T, size_t Columns, size_t Rows>
+struct Std140Matrix
+{
+    static constexpr size_t alignment = 16;
+    static constexpr size_t size = 16 * Columns;
+
+    static void Write (unsigned char* destination, const T& value)
+    {
+        for (size_t column = 0; column < Columns; column++)
+            std::memcpy (destination + 16 * column, glm::value_ptr (value) + Rows * column, 4 * Rows);
+    }
+};
+
+template <> struct Std140Traits<GLfloat> : Std140Vector<GLfloat, 1> {};
+template <> struct Std140Traits<GLint> : Std140Vector<GLint, 1> {};
+template <> struct Std140Traits<GLuint> : Std140Vector<GLuint, 1> {};
+
+template <> struct Std140Traits<glm::vec2> : Std140Vector<glm::vec2, 2> {};
+template <> struct Std140Traits<glm::vec3> : Std140Vector<glm::vec3, 3> {};
+template <> struct Std140Traits<glm::vec4> : Std140Vector<glm::vec4, 4> {};
+template <> struct Std140Traits<glm::ivec2> : Std140Vector<glm::ivec2, 2> {};
+template <> struct Std140Traits<glm::ivec3> : Std140Vector<glm::ivec3, 3> {};
+template <> struct Std140Traits<glm::ivec4> : Std140Vector<glm::ivec4, 4> {};
+template <> struct Std140Traits<glm::uvec2> : Std140Vector<glm::uvec2, 2> {};
+template <> struct Std140Traits<glm::uvec3> : Std140Vector<glm::uvec3, 3> {};
+template <> struct Std140Traits<glm::uvec4> : Std140Vector<glm::uvec4, 4> {};
+
+template <> struct Std140Traits<glm::mat2> : Std140Matrix<glm::mat2, 2, 2> {};
+template <> struct Std140Traits<glm::mat2x3> : Std140Matrix<glm::mat2x3, 2, 3> {};
+template <> struct Std140Traits<glm::mat2x4> : Std140Matrix<glm::mat2x4, 2, 4> {};
+template <> struct Std140Traits<glm::mat3x2> : Std140Matrix<glm::mat3x2, 3, 2> {};
+template <> struct Std140Traits<glm::mat3> : Std140Matrix<glm::mat3, 3, 3> {};
+template <> struct Std140Traits<glm::mat3x4> : Std140Matrix<glm::mat3x4, 3, 4> {};
+template <> struct Std140Traits<glm::mat4x2> : Std140Matrix<glm::mat4x2, 4, 2> {};
+template <> struct Std140Traits<glm::mat4x3> : Std140Matrix<glm::mat4x3, 4, 3> {};
+template <> struct Std140Traits<glm::mat4> : Std140Matrix<glm::mat4, 4, 4> {};
+
+/// <summary>
+/// Arrays round every element up to the size of a vec4.
+/// </summary>
+template <typename T, size_t N>
+struct Std140Traits<std::array<T, N>>
+{
+    static constexpr size_t stride = (Std140Traits<T>::size + 15) / 16 * 16;
+    static constexpr size_t alignment = 16;
+    static constexpr size_t size = stride * N;
+
+    static void Write (unsigned char* destination, const std::array<T, N>& value)
+    {
+        for (size_t i = 0; i < N; i++)
+            Std140Traits<T>::Write (destination + stride * i, value[i]);
+    }
+};
+
+/// <summary>
+/// The std140 layout of a uniform block whose members have the given types, in declaration order, computed at compile time.
+/// For example, a block { mat4 view; mat3 normal; vec3 eye; float time; } is Std140Layout&lt;glm::mat4, glm::mat3, glm::vec3, GLfloat&gt;.
+/// </summary>
+template <typename... Members>
+struct Std140Layout
+{
+private:
+    static constexpr std::array<size_t, sizeof... (Members)> ComputeOffsets ()
+    {
+        constexpr size_t alignments[] = { Std140Traits<Members>::alignment... };
+        constexpr size_t sizes[] = { Std140Traits<Members>::size... };
+
+        std::array<size_t, sizeof... (Members)> result = {};
+        size_t offset = 0;
+
+        for (size_t i = 0; i < sizeof... (Members); i++)
+        {
+            offset = (offset + alignments[i] - 1) / alignments[i] * alignments[i];
+            result[i] = offset;
+            offset += sizes[i];
+        }
+
+        return result;
+    }
+
+    static constexpr size_t ComputeSize ()
+    {
+        constexpr size_t sizes[] = { Std140Traits<Members>::size... };
+        constexpr std::array<size_t, sizeof... (Members)> memberOffsets = ComputeOffsets ();
+
+        //The block as a whole is rounded up to the alignment of a vec4
+        return (memberOffsets[sizeof... (Members) - 1] + sizes[sizeof... (Members) - 1] + 15) / 16 * 16;
+    }
+
+    template <size_t... Indices>
+    static void PackMembers (unsigned char* destination, std::index_sequence<Indices...>, const Members&... values)
+    {
+        (Std140Traits<Members>::Write (destination + offsets[Indices], values), ...);
+    }
+
+public:
+    static_assert (sizeof... (Members) > 0, "A uniform block needs at least one member");
+
+    /// <summary>
+    /// The byte offset of each member within the block.
+    /// </summary>
+    static constexpr std::array<size_t, sizeof... (Members)> offsets = ComputeOffsets ();
+
+    /// <summary>
+    /// The size of the block in bytes, as the driver reports it in GL_UNIFORM_BLOCK_DATA_SIZE.
+    /// </summary>
+    static constexpr size_t size = ComputeSize ();
+
+    /// <summary>
+    /// The type of the member at an index.
+    /// </summary>
+    template <size_t Index>
+    using Member = std::tuple_element_t<Index, std::tuple<Members...>>;
+
+    /// <summary>
+    /// Writes every member into a buffer of at least size bytes. Padding bytes are left untouched.
+    /// </summary>
+    static void Pack (void* destination, const Members&... values)
+    {
+        PackMembers (static_cast<unsigned char*> (destination), std::index_sequence_for<Members...> (), values...);
+    }
+
+    /// <summary>
+    /// Writes a single member into a buffer of at least size bytes.
+    /// </summary>
+    template <size_t Index>
+    static void Write (void* destination, const Member<Index>& value)
+    {
+        Std140Traits<Member<Index>>::Write (static_cast<unsigned char*> (destination) + offsets[Index], value);
+    }
+};
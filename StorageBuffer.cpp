@@ -0,0 +1,83 @@
+#include "StorageBuffer.h"
+
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "GLDispatch.h"
+
+static std::unordered_map<std::string, GLuint>& StorageBindingPoints ()
+{
+    static std::unordered_map<std::string, GLuint> bindingPoints;
+    return bindingPoints;
+}
+
+// Whether each binding point is taken, by a name or by a binding declared in a shader
+static std::vector<bool>& UsedStorageBindingPoints ()
+{
+    static std::vector<bool> usedBindingPoints;
+    return usedBindingPoints;
+}
+
+static void MarkStorageBindingPoint (GLuint bindingPoint)
+{
+    std::vector<bool>& used = UsedStorageBindingPoints ();
+
+    if (used.size () <= bindingPoint)
+        used.resize (bindingPoint + 1);
+
+    used[bindingPoint] = true;
+}
+
+GLuint GetStorageBindingPoint (const std::string& blockName)
+{
+    auto& bindingPoints = StorageBindingPoints ();
+    auto it = bindingPoints.find (blockName);
+
+    if (it != bindingPoints.end ())
+        return it->second;
+
+    GLint maxBindings;
+    GL ().GetIntegerv (GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &maxBindings);
+
+    const std::vector<bool>& used = UsedStorageBindingPoints ();
+    GLuint bindingPoint = 0;
+
+    while (bindingPoint < used.size () && used[bindingPoint])
+        bindingPoint++;
+
+    if (static_cast<GLint> (bindingPoint) >= maxBindings)
+    {
+        std::cerr << "Out of shader storage buffer binding points for block: " << blockName << "\n";
+        exit (EXIT_FAILURE);
+    }
+
+    bindingPoints.emplace (blockName, bindingPoint);
+    MarkStorageBindingPoint (bindingPoint);
+
+    return bindingPoint;
+}
+
+void ReserveStorageBindingPoint (const std::string& blockName, GLuint bindingPoint)
+{
+    auto& bindingPoints = StorageBindingPoints ();
+    auto it = bindingPoints.find (blockName);
+
+    if (it != bindingPoints.end ())
+    {
+        if (it->second != bindingPoint)
+            std::cerr << "Storage block " << blockName << " is declared with binding " << bindingPoint << " but its buffers are bound at " << it->second << "\n";
+
+        MarkStorageBindingPoint (bindingPoint);
+        return;
+    }
+
+    for (const auto& other : bindingPoints)
+    {
+        if (other.second == bindingPoint)
+            std::cerr << "Storage block " << blockName << " is declared with binding " << bindingPoint << ", which is already used by block " << other.first << "\n";
+    }
+
+    bindingPoints.emplace (blockName, bindingPoint);
+    MarkStorageBindingPoint (bindingPoint);
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "GLDispatch.h"
+
+/// <summary>
+/// Returns the binding point of a shader storage block, assigning the lowest free one the first time a name is seen.
+/// Exits if more blocks are used than the context has binding points.
+/// </summary>
+/// <param name="blockName">The name of the block as it appears in the shader code.</param>
+GLuint GetStorageBindingPoint (const std::string& blockName);
+
+/// <summary>
+/// Gives a shader storage block the binding point a program declares for it, so that buffers bound by name are bound there
+/// and no other block is assigned it. Reports a conflict if the name or the binding point is already taken by another.
+/// </summary>
+/// <param name="blockName">The name of the block as it appears in the shader code.</param>
+/// <param name="bindingPoint">The binding point declared in the shader.</param>
+void ReserveStorageBindingPoint (const std::string& blockName, GLuint bindingPoint);
+
+/// <summary>
+/// A shader storage buffer holding an array of T, e.g. a skinning palette or per-instance data.
+/// A CPU copy of the contents is kept so that assigning a new array only uploads the range that changed.
+/// T must match the std430 array stride of the block's element type, e.g. glm::vec4 rather than glm::vec3.
+/// </summary>
+/// <typeparam name="T">The element type of the array.</typeparam>
+template <typename T>
+class StorageBuffer
+{
+    static_assert (std::is_trivially_copyable<T>::value, "Storage buffer elements must be trivially copyable");
+
+private:
+    GLuint bufferID;
+    std::vector<T> values;
+    // Size of the GPU allocation in elements; values may be shorter after an assignment that shrank the array
+    size_t capacity = 0;
+
+    StorageBuffer () = default;
+
+    void Allocate (size_t count);
+
+public:
+    ~StorageBuffer ();
+
+    StorageBuffer (const StorageBuffer&) = delete;
+    StorageBuffer& operator= (const StorageBuffer&) = delete;
+
+    /// <summary>
+    /// Creates a buffer holding count zeroed elements.
+    /// </summary>
+    static std::unique_ptr<StorageBuffer> Create (size_t count);
+
+    /// <summary>
+    /// Creates a buffer holding a copy of an array.
+    /// </summary>
+    static std::unique_ptr<StorageBuffer> Create (const std::vector<T>& array);
+
+    /// <summary>
+    /// Replaces the contents of the buffer, uploading only the range of elements that differ from the current contents.
+    /// The buffer is reallocated if the array has grown or become empty.
+    /// </summary>
+    void Assign (const std::vector<T>& array);
+
+    /// <summary>
+    /// Writes count elements starting at element first. Exits if the range is outside the buffer.
+    /// </summary>
+    void Update (size_t first, const T* data, size_t count);
+
+    /// <summary>
+    /// Writes a single element. Exits if the index is outside the buffer.
+    /// </summary>
+    void Update (size_t index, const T& value);
+
+    /// <summary>
+    /// Binds the buffer to the binding point of a storage block.
+    /// </summary>
+    /// <param name="blockName">The name of the block as it appears in the shader code.</param>
+    void Bind (const std::string& blockName) const;
+
+    /// <summary>
+    /// Binds the elements of the buffer to a binding point. Only the current elements are bound, so the length of a trailing
+    /// unsized array in the block is the number of elements, even after an assignment that shrank the array.
+    /// </summary>
+    /// <param name="bindingPoint">The shader storage buffer binding point.</param>
+    void BindTo (GLuint bindingPoint) const;
+
+    /// <summary>
+    /// Returns the elements of the buffer, as last written.
+    /// </summary>
+    const std::vector<T>& GetValues () const;
+
+    /// <summary>
+    /// Returns the number of elements in the buffer.
+    /// </summary>
+    size_t GetCount () const;
+
+    /// <summary>
+    /// Returns the GL name of the buffer.
+    /// </summary>
+    GLuint GetBufferID () const;
+};
+
+template <typename T>
+StorageBuffer<T>::~StorageBuffer ()
+{
+    GL ().DeleteBuffers (1, &bufferID);
+}
+
+template <typename T>
+void StorageBuffer<T>::Allocate (size_t count)
+{
+    capacity = count;
+    GL ().BindBuffer (GL_SHADER_STORAGE_BUFFER, bufferID);
+    GL ().BufferData (GL_SHADER_STORAGE_BUFFER, count * sizeof (T), values.data (), GL_DYNAMIC_DRAW);
+}
+
+template <typename T>
+std::unique_ptr<StorageBuffer<T>> StorageBuffer<T>::Create (size_t count)
+{
+    return Create (std::vector<T> (count));
+}
+
+template <typename T>
+std::unique_ptr<StorageBuffer<T>> StorageBuffer<T>::Create (const std::vector<T>& array)
+{
+    std::unique_ptr<StorageBuffer> buffer (new StorageBuffer ());
+
+    GL ().GenBuffers (1, &buffer->bufferID);
+    buffer->values = array;
+    buffer->Allocate (array.size ());
+
+    return buffer;
+}
+
+template <typename T>
+void StorageBuffer<T>::Assign (const std::vector<T>& array)
+{
+    //An empty array cannot be bound as a range, so it gets an empty allocation that is bound whole
+    if (array.size () > capacity || (array.empty () && capacity > 0))
+    {
+        values = array;
+        Allocate (array.size ());
+        return;
+    }
+
+    size_t count = std::min (array.size (), values.size ());
+    size_t first = 0;
+
+    while (first < count && std::memcmp (&values[first], &array[first], sizeof (T)) == 0)
+        first++;
+
+    //Elements beyond the old contents always count as changed
+    size_t last = array.size ();
+
+    if (array.size () <= values.size ())
+        while (last > first && std::memcmp (&values[last - 1], &array[last - 1], sizeof (T)) == 0)
+            last--;
+
+    values = array;
+
+    if (first < last)
+    {
+        GL ().BindBuffer (GL_SHADER_STORAGE_BUFFER, bufferID);
+        GL ().BufferSubData (GL_SHADER_STORAGE_BUFFER, first * sizeof (T), (last - first) * sizeof (T), values.data () + first);
+    }
+}
+
+template <typename T>
+void StorageBuffer<T>::Update (size_t first, const T* data, size_t count)
+{
+    if (first + count > values.size ())
+    {
+        std::cerr << "Storage buffer update of elements [" << first << ", " << first + count << ") is outside the " << values.size () << " elements of the buffer\n";
+        exit (EXIT_FAILURE);
+    }
+
+    std::copy (data, data + count, values.begin () + first);
+
+    GL ().BindBuffer (GL_SHADER_STORAGE_BUFFER, bufferID);
+    GL ().BufferSubData (GL_SHADER_STORAGE_BUFFER, first * sizeof (T), count * sizeof (T), data);
+}
+
+template <typename T>
+void StorageBuffer<T>::Update (size_t index, const T& value)
+{
+    Update (index, &value, 1);
+}
+
+template <typename T>
+void StorageBuffer<T>::Bind (const std::string& blockName) const
+{
+    BindTo (GetStorageBindingPoint (blockName));
+}
+
+template <typename T>
+void StorageBuffer<T>::BindTo (GLuint bindingPoint) const
+{
+    if (values.empty ())
+        GL ().BindBufferBase (GL_SHADER_STORAGE_BUFFER, bindingPoint, bufferID);
+    else
+        GL ().BindBufferRange (GL_SHADER_STORAGE_BUFFER, bindingPoint, bufferID, 0, values.size () * sizeof (T));
+}
+
+template <typename T>
+const std::vector<T>& StorageBuffer<T>::GetValues () const
+{
+    return values;
+}
+
+template <typename T>
+size_t StorageBuffer<T>::GetCount () const
+{
+    return values.size ();
+}
+
+template <typename T>
+GLuint StorageBuffer<T>::GetBufferID () const
+{
+    return bufferID;
+}
@@ -0,0 +1,142 @@
+#include "UniformBuffer.h"
+
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "GLDispatch.h"
+
+static std::unordered_map<std::string, GLuint>& BindingPoints ()
+{
+    static std::unordered_map<std::string, GLuint> bindingPoints;
+    return bindingPoints;
+}
+
+// Whether each binding point is taken, by a name or by a binding declared in a shader
+static std::vector<bool>& UsedBindingPoints ()
+{
+    static std::vector<bool> usedBindingPoints;
+    return usedBindingPoints;
+}
+
+static void MarkBindingPoint (GLuint bindingPoint)
+{
+    std::vector<bool>& used = UsedBindingPoints ();
+
+    if (used.size () <= bindingPoint)
+        used.resize (bindingPoint + 1);
+
+    used[bindingPoint] = true;
+}
+
+UniformBuffer::~UniformBuffer ()
+{
+    GL ().DeleteBuffers (1, &bufferID);
+}
+
+std::unique_ptr<UniformBuffer> UniformBuffer::Create (const std::string& blockName, GLsizeiptr size)
+{
+    std::unique_ptr<UniformBuffer> buffer (new UniformBuffer ());
+
+    buffer->blockName = blockName;
+    buffer->size = size;
+    buffer->bindingPoint = GetBindingPoint (blockName);
+
+    GL ().GenBuffers (1, &buffer->bufferID);
+    GL ().BindBuffer (GL_UNIFORM_BUFFER, buffer->bufferID);
+    GL ().BufferData (GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+    GL ().BindBufferBase (GL_UNIFORM_BUFFER, buffer->bindingPoint, buffer->bufferID);
+
+    return buffer;
+}
+
+GLuint UniformBuffer::GetBindingPoint (const std::string& blockName)
+{
+    auto& bindingPoints = BindingPoints ();
+    auto it = bindingPoints.find (blockName);
+
+    if (it != bindingPoints.end ())
+        return it->second;
+
+    GLint maxBindings;
+    GL ().GetIntegerv (GL_MAX_UNIFORM_BUFFER_BINDINGS, &maxBindings);
+
+    const std::vector<bool>& used = UsedBindingPoints ();
+    GLuint bindingPoint = 0;
+
+    while (bindingPoint < used.size () && used[bindingPoint])
+        bindingPoint++;
+
+    if (static_cast<GLint> (bindingPoint) >= maxBindings)
+    {
+        std::cerr << "Out of uniform buffer binding points for block: " << blockName << "\n";
+        exit (EXIT_FAILURE);
+    }
+
+    bindingPoints.emplace (blockName, bindingPoint);
+    MarkBindingPoint (bindingPoint);
+
+    return bindingPoint;
+}
+
+void UniformBuffer::ReserveBindingPoint (const std::string& blockName, GLuint bindingPoint)
+{
+    auto& bindingPoints = BindingPoints ();
+    auto it = bindingPoints.find (blockName);
+
+    if (it != bindingPoints.end ())
+    {
+        if (it->second != bindingPoint)
+            std::cerr << "Uniform block " << blockName << " is declared with binding " << bindingPoint << " but its buffers are bound at " << it->second << "\n";
+
+        MarkBindingPoint (bindingPoint);
+        return;
+    }
+
+    for (const auto& other : bindingPoints)
+    {
+        if (other.second == bindingPoint)
+            std::cerr << "Uniform block " << blockName << " is declared with binding " << bindingPoint << ", which is already used by block " << other.first << "\n";
+    }
+
+    bindingPoints.emplace (blockName, bindingPoint);
+    MarkBindingPoint (bindingPoint);
+}
+
+void UniformBuffer::Upload (const void* data)
+{
+    GL ().BindBuffer (GL_UNIFORM_BUFFER, bufferID);
+    GL ().BufferData (GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
+}
+
+void UniformBuffer::Upload (GLintptr offset, GLsizeiptr length, const void* data)
+{
+    if (offset == 0 && length == size)
+    {
+        Upload (data);
+        return;
+    }
+
+    GL ().BindBuffer (GL_UNIFORM_BUFFER, bufferID);
+    GL ().BufferSubData (GL_UNIFORM_BUFFER, offset, length, data);
+}
+
+void UniformBuffer::Bind () const
+{
+    GL ().BindBufferBase (GL_UNIFORM_BUFFER, bindingPoint, bufferID);
+}
+
+GLuint UniformBuffer::GetBufferID () const
+{
+    return bufferID;
+}
+
+GLuint UniformBuffer::GetBindingPoint () const
+{
+    return bindingPoint;
+}
+
+GLsizeiptr UniformBuffer::GetSize () const
+{
+    return size;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "Std140.h"
+
+/// <summary>
+/// A uniform buffer object backing a named uniform block.
+/// Every block name is given its own binding point, and every program that declares the block reads it from there,
+/// so data uploaded once is shared by all of them.
+/// </summary>
+class UniformBuffer
+{
+private:
+    GLuint bufferID;
+    GLuint bindingPoint;
+    GLsizeiptr size;
+    std::string blockName;
+
+    UniformBuffer () = default;
+
+public:
+    ~UniformBuffer ();
+
+    UniformBuffer (const UniformBuffer&) = delete;
+    UniformBuffer& operator= (const UniformBuffer&) = delete;
+
+    /// <summary>
+    /// Creates a buffer for a uniform block and binds it to the block's binding point.
+    /// </summary>
+    /// <param name="blockName">The name of the block as it appears in the shader code.</param>
+    /// <param name="size">The size of the block in bytes.</param>
+    static std::unique_ptr<UniformBuffer> Create (const std::string& blockName, GLsizeiptr size);
+
+    /// <summary>
+    /// Creates a buffer for a uniform block with a std140 layout.
+    /// </summary>
+    /// <typeparam name="Layout">The Std140Layout of the block.</typeparam>
+    /// <param name="blockName">The name of the block as it appears in the shader code.</param>
+    template <typename Layout>
+    static std::unique_ptr<UniformBuffer> Create (const std::string& blockName);
+
+    /// <summary>
+    /// Returns the binding point of a uniform block, assigning the lowest free one the first time a name is seen.
+    /// Exits if more blocks are used than the context has binding points.
+    /// </summary>
+    /// <param name="blockName">The name of the block as it appears in the shader code.</param>
+    static GLuint GetBindingPoint (const std::string& blockName);
+
+    /// <summary>
+    /// Gives a uniform block the binding point a program declares for it, so that buffers created for the name are bound there
+    /// and no other block is assigned it. Reports a conflict if the name or the binding point is already taken by another.
+    /// </summary>
+    /// <param name="blockName">The name of the block as it appears in the shader code.</param>
+    /// <param name="bindingPoint">The binding point declared in the shader.</param>
+    static void ReserveBindingPoint (const std::string& blockName, GLuint bindingPoint);
+
+    /// <summary>
+    /// Replaces the contents of the buffer. The previous storage is orphaned, so the upload does not wait for draws still reading it.
+    /// </summary>
+    /// <param name="data">The new contents, of the size the buffer was created with.</param>
+    void Upload (const void* data);
+
+    /// <summary>
+    /// Replaces part of the contents of the buffer.
+    /// </summary>
+    /// <param name="offset">The byte offset to write at.</param>
+    /// <param name="length">The number of bytes to write.</param>
+    /// <param name="data">The bytes to write.</param>
+    void Upload (GLintptr offset, GLsizeiptr length, const void* data);
+
+    /// <summary>
+    /// Packs values with a std140 layout and uploads them as the whole contents of the buffer.
+    /// </summary>
+    /// <typeparam name="Layout">The Std140Layout of the block.</typeparam>
+    template <typename Layout, typename... Values>
+    void Pack (const Values&... values);
+
+    /// <summary>
+    /// Binds the buffer to its block's binding point again, e.g. after the binding was changed through GL directly.
+    /// </summary>
+    void Bind () const;
+
+    /// <summary>
+    /// Returns the GL name of the buffer.
+    /// </summary>
+    GLuint GetBufferID () const;
+
+    /// <summary>
+    /// Returns the binding point the buffer is bound to.
+    /// </summary>
+    GLuint GetBindingPoint () const;
+
+    /// <summary>
+    /// Returns the size of the buffer in bytes.
+    /// </summary>
+    GLsizeiptr GetSize () const;
+};
+
+template <typename Layout>
+std::unique_ptr<UniformBuffer> UniformBuffer::Create (const std::string& blockName)
+{
+    return Create (blockName, Layout::size);
+}
+
+template <typename Layout, typename... Values>
+void UniformBuffer::Pack (const Values&... values)
+{
+    alignas (16) unsigned char data[Layout::size] = {};
+    Layout::Pack (data, values...);
+    Upload (0, Layout::size, data);
+}
@@ -0,0 +1,109 @@
+#include "UniformCommandBuffer.h"
+
+#include <algorithm>
+#include <tuple>
+
+std::unique_ptr<UniformCommandBuffer> UniformCommandBuffer::Create (size_t blockSize)
+{
+    std::unique_ptr<UniformCommandBuffer> buffer (new UniformCommandBuffer ());
+    buffer->blockSize = blockSize;
+
+    return buffer;
+}
+
+void* UniformCommandBuffer::Allocate (size_t size)
+{
+    //Move on to the next block, reusing blocks kept from earlier recordings before allocating a new one
+    while (currentBlock < blocks.size () && blocks[currentBlock].used + size > blocks[currentBlock].capacity)
+        currentBlock++;
+
+    if (currentBlock == blocks.size ())
+    {
+        size_t capacity = std::max (blockSize, size) / RecordAlignment * RecordAlignment;
+        blocks.push_back ({ std::unique_ptr<std::max_align_t[]> (new std::max_align_t[capacity / RecordAlignment]), capacity, 0 });
+    }
+
+    Block& block = blocks[currentBlock];
+    void* memory = reinterpret_cast<unsigned char*> (block.data.get ()) + block.used;
+    block.used += size;
+
+    return memory;
+}
+
+UniformCommandBuffer::ReplayStats UniformCommandBuffer::Replay () const
+{
+    commands.clear ();
+
+    for (const Block& block : blocks)
+    {
+        for (size_t offset = 0; offset < block.used;)
+        {
+            const Command* command = reinterpret_cast<const Command*> (reinterpret_cast<const unsigned char*> (block.data.get ()) + offset);
+            commands.push_back (command);
+            offset += command->size;
+        }
+    }
+
+    //A record is dropped when a later one writes exactly the same elements of the same uniform
+    order.resize (commands.size ());
+
+    for (std::uint32_t i = 0; i < order.size (); i++)
+        order[i] = i;
+
+    auto key = [this] (std::uint32_t i)
+    {
+        const Command* command = commands[i];
+        return std::make_tuple (command->program, command->index, command->location, command->element, command->count);
+    };
+
+    std::sort (order.begin (), order.end (), [&] (std::uint32_t a, std::uint32_t b) { return std::make_pair (key (a), a) < std::make_pair (key (b), b); });
+
+    superseded.assign (commands.size (), false);
+
+    for (size_t i = 0; i + 1 < order.size (); i++)
+    {
+        if (key (order[i]) == key (order[i + 1]))
+            superseded[order[i]] = true;
+    }
+
+    ReplayStats stats = {};
+
+    for (size_t i = 0; i < commands.size (); i++)
+    {
+        if (superseded[i])
+        {
+            stats.merged++;
+            continue;
+        }
+
+        const Command* command = commands[i];
+        command->store (*command->program, command->generation, command->index, command->location, command->element, command->count, command + 1);
+        stats.records++;
+    }
+
+    return stats;
+}
+
+void UniformCommandBuffer::Reset ()
+{
+    for (Block& block : blocks)
+        block.used = 0;
+
+    currentBlock = 0;
+    recordCount = 0;
+}
+
+size_t UniformCommandBuffer::GetRecordCount () const
+{
+    return recordCount;
+}
+
+size_t UniformCommandBuffer::GetCapacity () const
+{
+    size_t capacity = 0;
+
+    for (const Block& block : blocks)
+        capacity += block.capacity;
+
+    return capacity;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "ShaderProgram.h"
+#include "UniformHandle.h"
+
+/// <summary>
+/// A list of uniform writes recorded away from the GL thread and replayed on it later.
+/// Each worker thread records into its own buffer, so recording takes no locks; records are written into arena blocks that
+/// are kept across Reset, so once a buffer has grown to its working size recording allocates nothing.
+/// Replay applies the records in order through the programs' uniform caches, and drops writes that a later record of the
+/// same buffer overwrites.
+/// </summary>
+class UniformCommandBuffer
+{
+public:
+    /// <summary>
+    /// Counts the records replayed and those dropped because a later record wrote the same elements.
+    /// </summary>
+    struct ReplayStats
+    {
+        std::uint64_t records;
+        std::uint64_t merged;
+    };
+
+private:
+    typedef void (*StoreFunction) (const ShaderProgram& program, std::uint32_t generation, GLint index, GLint location, GLint element, GLsizei count, const void* data);
+
+    // Followed in the arena by the values, padded so the next record stays aligned
+    struct Command
+    {
+        const ShaderProgram* program;
+        StoreFunction store;
+        std::uint32_t generation;
+        GLint index;
+        GLint location;
+        GLint element;
+        GLsizei count;
+        std::uint32_t size;
+    };
+
+    struct Block
+    {
+        std::unique_ptr<std::max_align_t[]> data;
+        size_t capacity;
+        size_t used;
+    };
+
+    static constexpr size_t RecordAlignment = alignof (std::max_align_t);
+
+    std::vector<Block> blocks;
+    size_t currentBlock = 0;
+    size_t blockSize;
+    size_t recordCount = 0;
+
+    // Reused by Replay so replaying allocates nothing either once the buffer has reached its working size
+    mutable std::vector<const Command*> commands;
+    mutable std::vector<std::uint32_t> order;
+    mutable std::vector<bool> superseded;
+
+    UniformCommandBuffer () = default;
+
+    void* Allocate (size_t size);
+
+    template <typename T>
+    static void StoreRecord (const ShaderProgram& program, std::uint32_t generation, GLint index, GLint location, GLint element, GLsizei count, const void* data);
+
+public:
+    UniformCommandBuffer (const UniformCommandBuffer&) = delete;
+    UniformCommandBuffer& operator= (const UniformCommandBuffer&) = delete;
+
+    /// <summary>
+    /// Creates an empty command buffer.
+    /// </summary>
+    /// <param name="blockSize">The size in bytes of each arena block. Records larger than a block get a block of their own.</param>
+    static std::unique_ptr<UniformCommandBuffer> Create (size_t blockSize = 64 * 1024);
+
+    /// <summary>
+    /// Records a write of a uniform through a handle resolved beforehand. Writes to inactive uniforms are not recorded.
+    /// Safe to call from any thread, as long as each buffer is only used by one thread at a time.
+    /// </summary>
+    /// <param name="program">The program the handle belongs to. It must outlive the replay.</param>
+    /// <param name="uniform">The uniform to write.</param>
+    /// <param name="value">The value to write; it is copied into the buffer.</param>
+    template <typename T>
+    void Record (const ShaderProgram& program, const UniformHandle<T>& uniform, const T& value);
+
+    /// <summary>
+    /// Records a write of consecutive array elements through a handle resolved beforehand.
+    /// </summary>
+    /// <param name="program">The program the handle belongs to. It must outlive the replay.</param>
+    /// <param name="uniform">The uniform to write, or the first element to write, e.g. a handle to "bones[4]".</param>
+    /// <param name="values">The values to write; they are copied into the buffer.</param>
+    /// <param name="count">The number of values.</param>
+    template <typename T>
+    void Record (const ShaderProgram& program, const UniformHandle<T>& uniform, const T* values, GLsizei count);
+
+    /// <summary>
+    /// Applies the recorded writes in the order they were recorded. Must be called on the thread owning the GL context,
+    /// after the recording thread has finished with the buffer. Programs are written as the current uniform write mode
+    /// dictates, so with ShaderProgram::EnableDirectUniformWrites nothing needs to be bound.
+    /// </summary>
+    ReplayStats Replay () const;
+
+    /// <summary>
+    /// Discards the recorded writes, keeping the arena blocks for the next recording.
+    /// </summary>
+    void Reset ();
+
+    /// <summary>
+    /// Returns the number of recorded writes.
+    /// </summary>
+    size_t GetRecordCount () const;
+
+    /// <summary>
+    /// Returns the total size of the arena blocks in bytes.
+    /// </summary>
+    size_t GetCapacity () const;
+};
+
+template <typename T>
+void UniformCommandBuffer::StoreRecord (const ShaderProgram& program, std::uint32_t generation, GLint index, GLint location, GLint element, GLsizei count, const void* data)
+{
+    //Records made through a handle resolved before a hot reload are carried over by name, like writes through the handle itself
+    if (generation != program.generation)
+    {
+        program.StoreStale (generation, index, element, count, static_cast<const T*> (data));
+        return;
+    }
+
+    program.Store (index, location, element, count, static_cast<const T*> (data));
+}
+
+template <typename T>
+void UniformCommandBuffer::Record (const ShaderProgram& program, const UniformHandle<T>& uniform, const T& value)
+{
+    Record (program, uniform, &value, 1);
+}
+
+template <typename T>
+void UniformCommandBuffer::Record (const ShaderProgram& program, const UniformHandle<T>& uniform, const T* values, GLsizei count)
+{
+    if (!uniform.IsActive () || count <= 0)
+        return;
+
+    size_t payload = sizeof (T) * count;
+    size_t size = (sizeof (Command) + payload + RecordAlignment - 1) / RecordAlignment * RecordAlignment;
+    void* memory = Allocate (size);
+
+    Command* command = new (memory) Command { &program, &StoreRecord<T>, uniform.generation, uniform.index, uniform.location, uniform.element, count, static_cast<std::uint32_t> (size) };
+    std::memcpy (command + 1, values, payload);
+
+    recordCount++;
+}
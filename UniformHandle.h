@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstdint>
+
+#include <GL/glew.h>
+
+#include <glm/matrix.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "GLDispatch.h"
+
+/// <summary>
+/// Returns whether a uniform type is opaque (a sampler, image or atomic counter), i.e. set through glUniform1i.
+/// </summary>
+/// <param name="type">The GLSL type as reported by glGetActiveUniform.</param>
+inline bool IsOpaqueUniformType (GLenum type)
+{
+    switch (type)
+    {
+    case GL_FLOAT: case GL_FLOAT_VEC2: case GL_FLOAT_VEC3: case GL_FLOAT_VEC4:
+    case GL_DOUBLE: case GL_DOUBLE_VEC2: case GL_DOUBLE_VEC3: case GL_DOUBLE_VEC4:
+    case GL_INT: case GL_INT_VEC2: case GL_INT_VEC3: case GL_INT_VEC4:
+    case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+    case GL_BOOL: case GL_BOOL_VEC2: case GL_BOOL_VEC3: case GL_BOOL_VEC4:
+    case GL_FLOAT_MAT2: case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4:
+    case GL_FLOAT_MAT3x2: case GL_FLOAT_MAT3: case GL_FLOAT_MAT3x4:
+    case GL_FLOAT_MAT4x2: case GL_FLOAT_MAT4x3: case GL_FLOAT_MAT4:
+    case GL_DOUBLE_MAT2: case GL_DOUBLE_MAT2x3: case GL_DOUBLE_MAT2x4:
+    case GL_DOUBLE_MAT3x2: case GL_DOUBLE_MAT3: case GL_DOUBLE_MAT3x4:
+    case GL_DOUBLE_MAT4x2: case GL_DOUBLE_MAT4x3: case GL_DOUBLE_MAT4:
+        return false;
+    default:
+        return true;
+    }
+}
+
+/// <summary>
+/// Returns the size in bytes of one element of a uniform type, as passed to glUniform*.
+/// </summary>
+/// <param name="type">The GLSL type as reported by glGetActiveUniform.</param>
+inline GLsizei UniformTypeSize (GLenum type)
+{
+    switch (type)
+    {
+    case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: case GL_BOOL:
+        return 4;
+    case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2: case GL_DOUBLE:
+        return 8;
+    case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3:
+        return 12;
+    case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4: case GL_FLOAT_MAT2: case GL_DOUBLE_VEC2:
+        return 16;
+    case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT3x2: case GL_DOUBLE_VEC3:
+        return 24;
+    case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT4x2: case GL_DOUBLE_VEC4: case GL_DOUBLE_MAT2:
+        return 32;
+    case GL_FLOAT_MAT3:
+        return 36;
+    case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x3: case GL_DOUBLE_MAT2x3: case GL_DOUBLE_MAT3x2:
+        return 48;
+    case GL_FLOAT_MAT4: case GL_DOUBLE_MAT2x4: case GL_DOUBLE_MAT4x2:
+        return 64;
+    case GL_DOUBLE_MAT3:
+        return 72;
+    case GL_DOUBLE_MAT3x4: case GL_DOUBLE_MAT4x3:
+        return 96;
+    case GL_DOUBLE_MAT4:
+        return 128;
+    default:
+        //Samplers, images and atomic counters are set as a single GLint
+        return 4;
+    }
+}
+
+/// <summary>
+/// Maps a C++ uniform value type to the GLSL types it can be written to, the glUniform* call that writes it to the bound
+/// program, and the glProgramUniform* call that writes it to any program.
+/// </summary>
+template <typename T>
+struct UniformTraits;
+
+#define SHADER_UNIFORM_TRAITS(Type, GLType, BoolType, UploadCall, ProgramUploadCall)                \
+    template <>                                                                                     \
+    struct UniformTraits<Type>                                                                      \
+    {                                                                                               \
+        static constexpr GLenum glslType = GLType;                                                  \
+                                                                                                    \
+        static bool Accepts (GLenum type)                                                           \
+        {                                                                                           \
+            return type == GLType || type == BoolType;                                              \
+        }                                                                                           \
+                                                                                                    \
+        static void Upload (GLint location, GLsizei count, const Type* data)                        \
+        {                                                                                           \
+            UploadCall;                                                                             \
+        }                                                                                           \
+                                                                                                    \
+        static void ProgramUpload (GLuint program, GLint location, GLsizei count, const Type* data) \
+        {                                                                                           \
+            ProgramUploadCall;                                                                      \
+        }                                                                                           \
+    };
+
+SHADER_UNIFORM_TRAITS (GLfloat, GL_FLOAT, GL_NONE, GL ().Uniform1fv (location, count, data), GL ().ProgramUniform1fv (program, location, count, data))
+SHADER_UNIFORM_TRAITS (glm::vec2, GL_FLOAT_VEC2, GL_NONE, GL ().Uniform2fv (location, count, glm::value_ptr (*data)), GL ().ProgramUniform2fv (program, location, count, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::vec3, GL_FLOAT_VEC3, GL_NONE, GL ().Uniform3fv (location, count, glm::value_ptr (*data)), GL ().ProgramUniform3fv (program, location, count, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::vec4, GL_FLOAT_VEC4, GL_NONE, GL ().Uniform4fv (location, count, glm::value_ptr (*data)), GL ().ProgramUniform4fv (program, location, count, glm::value_ptr (*data)))
+
+SHADER_UNIFORM_TRAITS (glm::ivec2, GL_INT_VEC2, GL_BOOL_VEC2, GL ().Uniform2iv (location, count, glm::value_ptr (*data)), GL ().ProgramUniform2iv (program, location, count, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::ivec3, GL_INT_VEC3, GL_BOOL_VEC3, GL ().Uniform3iv (location, count, glm::value_ptr (*data)), GL ().ProgramUniform3iv (program, location, count, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::ivec4, GL_INT_VEC4, GL_BOOL_VEC4, GL ().Uniform4iv (location, count, glm::value_ptr (*data)), GL ().ProgramUniform4iv (program, location, count, glm::value_ptr (*data)))
+
+SHADER_UNIFORM_TRAITS (GLuint, GL_UNSIGNED_INT, GL_NONE, GL ().Uniform1uiv (location, count, data), GL ().ProgramUniform1uiv (program, location, count, data))
+SHADER_UNIFORM_TRAITS (glm::uvec2, GL_UNSIGNED_INT_VEC2, GL_NONE, GL ().Uniform2uiv (location, count, glm::value_ptr (*data)), GL ().ProgramUniform2uiv (program, location, count, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::uvec3, GL_UNSIGNED_INT_VEC3, GL_NONE, GL ().Uniform3uiv (location, count, glm::value_ptr (*data)), GL ().ProgramUniform3uiv (program, location, count, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::uvec4, GL_UNSIGNED_INT_VEC4, GL_NONE, GL ().Uniform4uiv (location, count, glm::value_ptr (*data)), GL ().ProgramUniform4uiv (program, location, count, glm::value_ptr (*data)))
+
+SHADER_UNIFORM_TRAITS (glm::mat2, GL_FLOAT_MAT2, GL_NONE, GL ().UniformMatrix2fv (location, count, GL_FALSE, glm::value_ptr (*data)), GL ().ProgramUniformMatrix2fv (program, location, count, GL_FALSE, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::mat2x3, GL_FLOAT_MAT2x3, GL_NONE, GL ().UniformMatrix2x3fv (location, count, GL_FALSE, glm::value_ptr (*data)), GL ().ProgramUniformMatrix2x3fv (program, location, count, GL_FALSE, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::mat2x4, GL_FLOAT_MAT2x4, GL_NONE, GL ().UniformMatrix2x4fv (location, count, GL_FALSE, glm::value_ptr (*data)), GL ().ProgramUniformMatrix2x4fv (program, location, count, GL_FALSE, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::mat3x2, GL_FLOAT_MAT3x2, GL_NONE, GL ().UniformMatrix3x2fv (location, count, GL_FALSE, glm::value_ptr (*data)), GL ().ProgramUniformMatrix3x2fv (program, location, count, GL_FALSE, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::mat3, GL_FLOAT_MAT3, GL_NONE, GL ().UniformMatrix3fv (location, count, GL_FALSE, glm::value_ptr (*data)), GL ().ProgramUniformMatrix3fv (program, location, count, GL_FALSE, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::mat3x4, GL_FLOAT_MAT3x4, GL_NONE, GL ().UniformMatrix3x4fv (location, count, GL_FALSE, glm::value_ptr (*data)), GL ().ProgramUniformMatrix3x4fv (program, location, count, GL_FALSE, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::mat4x2, GL_FLOAT_MAT4x2, GL_NONE, GL ().UniformMatrix4x2fv (location, count, GL_FALSE, glm::value_ptr (*data)), GL ().ProgramUniformMatrix4x2fv (program, location, count, GL_FALSE, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::mat4x3, GL_FLOAT_MAT4x3, GL_NONE, GL ().UniformMatrix4x3fv (location, count, GL_FALSE, glm::value_ptr (*data)), GL ().ProgramUniformMatrix4x3fv (program, location, count, GL_FALSE, glm::value_ptr (*data)))
+SHADER_UNIFORM_TRAITS (glm::mat4, GL_FLOAT_MAT4, GL_NONE, GL ().UniformMatrix4fv (location, count, GL_FALSE, glm::value_ptr (*data)), GL ().ProgramUniformMatrix4fv (program, location, count, GL_FALSE, glm::value_ptr (*data)))
+
+#undef SHADER_UNIFORM_TRAITS
+
+/// <summary>
+/// GLint is written to int and bool uniforms as well as samplers and other opaque types.
+/// </summary>
+template <>
+struct UniformTraits<GLint>
+{
+    static constexpr GLenum glslType = GL_INT;
+
+    static bool Accepts (GLenum type)
+    {
+        return type == GL_INT || type == GL_BOOL || IsOpaqueUniformType (type);
+    }
+
+    static void Upload (GLint location, GLsizei count, const GLint* data)
+    {
+        GL ().Uniform1iv (location, count, data);
+    }
+
+    static void ProgramUpload (GLuint program, GLint location, GLsizei count, const GLint* data)
+    {
+        GL ().ProgramUniform1iv (program, location, count, data);
+    }
+};
+
+/// <summary>
+/// A uniform of a program, resolved once and checked against the program's reflected uniform types.
+/// Writing through a handle skips any name lookup.
+/// </summary>
+/// <typeparam name="T">The C++ type written to the uniform.</typeparam>
+template <typename T>
+class UniformHandle
+{
+    friend class ShaderProgram;
+    friend class UniformCommandBuffer;
+
+    GLint location = -1;
+    GLenum type = GL_NONE;
+    GLint size = 0;
+
+    // Position in the program's uniform table, and the first array element the handle refers to
+    GLint index = -1;
+    GLint element = 0;
+    // The program generation the handle was resolved in; a hot reload rebuilds the table, so older handles are remapped by name
+    std::uint32_t generation = 0;
+
+public:
+    UniformHandle () = default;
+
+    /// <summary>
+    /// Returns the GL location of the uniform, or -1 if the uniform is not active in the program.
+    /// </summary>
+    GLint GetLocation () const
+    {
+        return location;
+    }
+
+    /// <summary>
+    /// Returns the GLSL type of the uniform as reported by the program.
+    /// </summary>
+    GLenum GetType () const
+    {
+        return type;
+    }
+
+    /// <summary>
+    /// Returns the number of array elements of the uniform, or 1 if it is not an array.
+    /// </summary>
+    GLint GetSize () const
+    {
+        return size;
+    }
+
+    /// <summary>
+    /// Returns whether the uniform is active in the program. Writes to an inactive uniform are ignored, as in GL.
+    /// </summary>
+    bool IsActive () const
+    {
+        return location != -1;
+    }
+};
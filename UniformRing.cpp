@@ -0,0 +1,159 @@
+#include "UniformRing.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "UniformBuffer.h"
+
+UniformRing::~UniformRing ()
+{
+    for (GLsizei i = 0; i < frameCount; i++)
+        if (fences[i])
+            GL ().DeleteSync (fences[i]);
+
+    GL ().BindBuffer (GL_UNIFORM_BUFFER, bufferID);
+    GL ().UnmapBuffer (GL_UNIFORM_BUFFER);
+    GL ().DeleteBuffers (1, &bufferID);
+}
+
+std::unique_ptr<UniformRing> UniformRing::Create (const std::string& blockName, GLsizeiptr blockSize, GLsizei slicesPerFrame, GLsizei frameCount)
+{
+    if (!GL ().HasBufferStorage ())
+    {
+        std::cerr << "Persistently mapped buffers are not supported, cannot create ring for block: " << blockName << "\n";
+        exit (EXIT_FAILURE);
+    }
+
+    std::unique_ptr<UniformRing> ring (new UniformRing ());
+
+    GLint alignment;
+    GL ().GetIntegerv (GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+    ring->blockName = blockName;
+    ring->blockSize = blockSize;
+    ring->stride = (blockSize + alignment - 1) / alignment * alignment;
+    ring->slicesPerFrame = slicesPerFrame;
+    ring->frameCount = frameCount;
+    ring->bindingPoint = UniformBuffer::GetBindingPoint (blockName);
+    ring->fences.reset (new GLsync[frameCount] ());
+
+    GLsizeiptr size = ring->stride * slicesPerFrame * frameCount;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    GL ().GenBuffers (1, &ring->bufferID);
+    GL ().BindBuffer (GL_UNIFORM_BUFFER, ring->bufferID);
+    GL ().BufferStorage (GL_UNIFORM_BUFFER, size, NULL, flags);
+    ring->mapping = static_cast<unsigned char*> (GL ().MapBufferRange (GL_UNIFORM_BUFFER, 0, size, flags));
+
+    if (!ring->mapping)
+    {
+        std::cerr << "Failed to map ring buffer for block: " << blockName << "\n";
+        exit (EXIT_FAILURE);
+    }
+
+    return ring;
+}
+
+std::unique_ptr<UniformRing> UniformRing::Create (const ShaderProgram& program, const std::string& blockName, GLsizei slicesPerFrame, GLsizei frameCount)
+{
+    const ShaderProgram::BlockInfo* block = program.FindUniformBlock (blockName.c_str ());
+
+    if (!block)
+    {
+        std::cerr << "Uniform block " << blockName << " is not active in shader program\n";
+        exit (EXIT_FAILURE);
+    }
+
+    return Create (blockName, block->dataSize, slicesPerFrame, frameCount);
+}
+
+void UniformRing::BeginFrame ()
+{
+    frame = (frame + 1) % frameCount;
+    slice = 0;
+    inFrame = true;
+
+    GLsync& fence = fences[frame];
+
+    if (!fence)
+        return;
+
+    //Poll without flushing first; the fence was issued a whole ring ago and is usually signalled already. Only the waits after
+    //a timeout flush, so a fence still sitting in the command queue is sure to reach the GPU
+    GLenum result = GL ().ClientWaitSync (fence, 0, 0);
+
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        stats.stalls++;
+
+        do
+            result = GL ().ClientWaitSync (fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        while (result == GL_TIMEOUT_EXPIRED);
+    }
+
+    GL ().DeleteSync (fence);
+    fence = nullptr;
+}
+
+void UniformRing::EndFrame ()
+{
+    fences[frame] = GL ().FenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    inFrame = false;
+}
+
+unsigned char* UniformRing::NextSlice (GLintptr& offset, size_t writeSize)
+{
+    //A larger write would run into the next slice, which the GPU may still be reading, or past the end of the mapping
+    if (writeSize > static_cast<size_t> (blockSize))
+    {
+        std::cerr << "Ring for block " << blockName << " written with " << writeSize << " bytes, but the block holds " << blockSize << "\n";
+        exit (EXIT_FAILURE);
+    }
+
+    if (!inFrame)
+    {
+        std::cerr << "Ring for block " << blockName << " written outside of BeginFrame and EndFrame\n";
+        exit (EXIT_FAILURE);
+    }
+
+    if (slice == slicesPerFrame)
+    {
+        std::cerr << "Ring for block " << blockName << " overflowed its " << slicesPerFrame << " slices per frame\n";
+        exit (EXIT_FAILURE);
+    }
+
+    offset = (static_cast<GLintptr> (frame) * slicesPerFrame + slice) * stride;
+    slice++;
+    stats.pushes++;
+
+    return mapping + offset;
+}
+
+GLintptr UniformRing::Push (const void* data)
+{
+    GLintptr offset;
+    std::memcpy (NextSlice (offset, blockSize), data, blockSize);
+    GL ().BindBufferRange (GL_UNIFORM_BUFFER, bindingPoint, bufferID, offset, blockSize);
+
+    return offset;
+}
+
+GLuint UniformRing::GetBufferID () const
+{
+    return bufferID;
+}
+
+GLuint UniformRing::GetBindingPoint () const
+{
+    return bindingPoint;
+}
+
+GLsizeiptr UniformRing::GetStride () const
+{
+    return stride;
+}
+
+UniformRing::RingStats UniformRing::GetStats () const
+{
+    return stats;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "GLDispatch.h"
+#include "ShaderProgram.h"
+#include "Std140.h"
+
+/// <summary>
+/// Streams per-draw contents of a uniform block through one persistently mapped buffer.
+/// The buffer is split into one region per frame in flight; each draw copies its block into the current region and binds
+/// that slice with glBindBufferRange, and a fence per region keeps the CPU from overwriting data the GPU has not read yet.
+/// </summary>
+class UniformRing
+{
+public:
+    /// <summary>
+    /// Counts the slices written and the times BeginFrame had to wait for the GPU to finish with a region.
+    /// </summary>
+    struct RingStats
+    {
+        std::uint64_t pushes;
+        std::uint64_t stalls;
+    };
+
+private:
+    GLuint bufferID;
+    GLuint bindingPoint;
+    std::string blockName;
+
+    // Size of one block, and the distance between slices after rounding up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    GLsizeiptr blockSize;
+    GLsizeiptr stride;
+    GLsizei slicesPerFrame;
+    GLsizei frameCount;
+
+    unsigned char* mapping;
+    std::unique_ptr<GLsync[]> fences;
+
+    GLsizei frame = 0;
+    GLsizei slice = 0;
+    bool inFrame = false;
+
+    RingStats stats = {};
+
+    UniformRing () = default;
+
+    unsigned char* NextSlice (GLintptr& offset, size_t writeSize);
+
+public:
+    ~UniformRing ();
+
+    UniformRing (const UniformRing&) = delete;
+    UniformRing& operator= (const UniformRing&) = delete;
+
+    /// <summary>
+    /// Creates a ring for a uniform block. Exits if persistent mapping (GL 4.4 or ARB_buffer_storage) is not supported.
+    /// </summary>
+    /// <param name="blockName">The name of the block as it appears in the shader code.</param>
+    /// <param name="blockSize">The size of the block in bytes.</param>
+    /// <param name="slicesPerFrame">The most draws that push a block between BeginFrame and EndFrame.</param>
+    /// <param name="frameCount">The number of frames the GPU may lag behind the CPU, 3 for triple buffering.</param>
+    static std::unique_ptr<UniformRing> Create (const std::string& blockName, GLsizeiptr blockSize, GLsizei slicesPerFrame, GLsizei frameCount = 3);
+
+    /// <summary>
+    /// Creates a ring for a uniform block of a program, sized from the program's reflection of the block.
+    /// Exits if the program has no active block with that name.
+    /// </summary>
+    /// <param name="program">A program declaring the block.</param>
+    /// <param name="blockName">The name of the block as it appears in the shader code.</param>
+    /// <param name="slicesPerFrame">The most draws that push a block between BeginFrame and EndFrame.</param>
+    /// <param name="frameCount">The number of frames the GPU may lag behind the CPU, 3 for triple buffering.</param>
+    static std::unique_ptr<UniformRing> Create (const ShaderProgram& program, const std::string& blockName, GLsizei slicesPerFrame, GLsizei frameCount = 3);
+
+    /// <summary>
+    /// Moves to the next region of the ring, waiting for the GPU if it is still reading the draws written there frameCount frames ago.
+    /// </summary>
+    void BeginFrame ();
+
+    /// <summary>
+    /// Fences the draws issued since BeginFrame, so the region can be reused once the GPU has executed them.
+    /// </summary>
+    void EndFrame ();
+
+    /// <summary>
+    /// Copies the contents of the block for the next draw into the ring and binds that slice to the block's binding point.
+    /// Exits if more than slicesPerFrame slices are pushed in one frame.
+    /// </summary>
+    /// <param name="data">The contents of the block, blockSize bytes long.</param>
+    /// <returns>The offset of the slice in the buffer.</returns>
+    GLintptr Push (const void* data);
+
+    /// <summary>
+    /// Packs values with a std140 layout straight into the next slice of the ring and binds that slice.
+    /// Exits if the layout is larger than the block the ring was created for.
+    /// </summary>
+    /// <typeparam name="Layout">The Std140Layout of the block.</typeparam>
+    /// <returns>The offset of the slice in the buffer.</returns>
+    template <typename Layout, typename... Values>
+    GLintptr Push (const Values&... values);
+
+    /// <summary>
+    /// Returns the GL name of the buffer.
+    /// </summary>
+    GLuint GetBufferID () const;
+
+    /// <summary>
+    /// Returns the binding point the slices are bound to.
+    /// </summary>
+    GLuint GetBindingPoint () const;
+
+    /// <summary>
+    /// Returns the distance in bytes between consecutive slices.
+    /// </summary>
+    GLsizeiptr GetStride () const;
+
+    /// <summary>
+    /// Returns how many slices were pushed and how many times BeginFrame waited for the GPU.
+    /// </summary>
+    RingStats GetStats () const;
+};
+
+template <typename Layout, typename... Values>
+GLintptr UniformRing::Push (const Values&... values)
+{
+    GLintptr offset;
+    unsigned char* destination = NextSlice (offset, Layout::size);
+
+    Layout::Pack (destination, values...);
+    GL ().BindBufferRange (GL_UNIFORM_BUFFER, bindingPoint, bufferID, offset, blockSize);
+
+    return offset;
+}
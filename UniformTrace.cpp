@@ -0,0 +1,381 @@
+#include "UniformTrace.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "ShaderProgram.h"
+
+std::unique_ptr<UniformTrace> UniformTrace::capture;
+
+static const char traceMagic[4] = { 'U', 'T', 'R', 'C' };
+static const unsigned char traceVersion = 1;
+
+/// <summary>
+/// Decodes the records of a trace. Every read is bounds-checked, so a truncated or corrupt trace sets failed instead of
+/// reading past the end.
+/// </summary>
+struct TraceReader
+{
+    const unsigned char* position;
+    const unsigned char* end;
+    bool failed = false;
+
+    bool AtEnd () const
+    {
+        return position >= end;
+    }
+
+    unsigned char Byte ()
+    {
+        if (position >= end)
+        {
+            failed = true;
+            return 0;
+        }
+
+        return *position++;
+    }
+
+    std::uint64_t Varint ()
+    {
+        std::uint64_t value = 0;
+
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            unsigned char byte = Byte ();
+            value |= static_cast<std::uint64_t> (byte & 0x7F) << shift;
+
+            if (!(byte & 0x80))
+                return value;
+        }
+
+        failed = true;
+        return 0;
+    }
+
+    const unsigned char* Bytes (std::uint64_t length)
+    {
+        if (length > static_cast<std::uint64_t> (end - position))
+        {
+            failed = true;
+            return end;
+        }
+
+        const unsigned char* bytes = position;
+        position += length;
+        return bytes;
+    }
+};
+
+//Element indices are stored zigzag-encoded, so the rare negative index still takes a single byte
+static std::uint64_t ZigzagEncode (GLint value)
+{
+    return (static_cast<std::uint32_t> (value) << 1) ^ static_cast<std::uint32_t> (value >> 31);
+}
+
+static GLint ZigzagDecode (std::uint64_t value)
+{
+    std::uint32_t encoded = static_cast<std::uint32_t> (value);
+    return static_cast<GLint> ((encoded >> 1) ^ (0u - (encoded & 1)));
+}
+
+void UniformTrace::WriteVarint (std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        records.push_back (static_cast<unsigned char> (value | 0x80));
+        value >>= 7;
+    }
+
+    records.push_back (static_cast<unsigned char> (value));
+}
+
+std::uint32_t UniformTrace::Intern (std::unordered_map<std::string, std::uint32_t>& indices, Opcode opcode, const std::string& name)
+{
+    auto it = indices.find (name);
+
+    if (it != indices.end ())
+        return it->second;
+
+    std::uint32_t index = static_cast<std::uint32_t> (indices.size ());
+    indices.emplace (name, index);
+
+    records.push_back (opcode);
+    WriteVarint (name.size ());
+    records.insert (records.end (), name.begin (), name.end ());
+
+    return index;
+}
+
+void UniformTrace::BeginCapture ()
+{
+    if (capture)
+    {
+        std::cerr << "A uniform trace capture is already running\n";
+        exit (EXIT_FAILURE);
+    }
+
+    capture.reset (new UniformTrace ());
+}
+
+std::unique_ptr<UniformTrace> UniformTrace::EndCapture ()
+{
+    std::unique_ptr<UniformTrace> trace = std::move (capture);
+
+    if (trace)
+    {
+        trace->programIndices.clear ();
+        trace->uniformIndices.clear ();
+    }
+
+    return trace;
+}
+
+void UniformTrace::MarkFrame ()
+{
+    if (!capture)
+        return;
+
+    capture->records.push_back (EndFrame);
+    capture->frameCount++;
+}
+
+void UniformTrace::RecordBind (const std::string& programName)
+{
+    std::uint32_t program = capture->Intern (capture->programIndices, DefineProgram, programName);
+
+    capture->records.push_back (Bind);
+    capture->WriteVarint (program);
+}
+
+void UniformTrace::RecordWrite (const std::string& programName, const std::string& uniformName, GLenum type, GLint element, GLsizei count, const void* data, size_t size)
+{
+    std::uint32_t program = capture->Intern (capture->programIndices, DefineProgram, programName);
+    std::uint32_t uniform = capture->Intern (capture->uniformIndices, DefineUniform, uniformName);
+
+    capture->records.push_back (Write);
+    capture->WriteVarint (program);
+    capture->WriteVarint (uniform);
+    capture->WriteVarint (type);
+    capture->WriteVarint (ZigzagEncode (element));
+    capture->WriteVarint (static_cast<std::uint64_t> (count));
+    capture->WriteVarint (size);
+
+    const unsigned char* bytes = static_cast<const unsigned char*> (data);
+    capture->records.insert (capture->records.end (), bytes, bytes + size);
+}
+
+bool UniformTrace::Validate ()
+{
+    TraceReader reader = { records.data (), records.data () + records.size () };
+    std::uint64_t programCount = 0;
+    std::uint64_t uniformCount = 0;
+    frameCount = 0;
+
+    while (!reader.AtEnd () && !reader.failed)
+    {
+        switch (reader.Byte ())
+        {
+        case EndFrame:
+            frameCount++;
+            break;
+        case DefineProgram:
+            reader.Bytes (reader.Varint ());
+            programCount++;
+            break;
+        case DefineUniform:
+            reader.Bytes (reader.Varint ());
+            uniformCount++;
+            break;
+        case Bind:
+            reader.failed |= reader.Varint () >= programCount;
+            break;
+        case Write:
+        {
+            reader.failed |= reader.Varint () >= programCount;
+            reader.failed |= reader.Varint () >= uniformCount;
+            GLenum type = static_cast<GLenum> (reader.Varint ());
+            reader.Varint ();
+            std::uint64_t count = reader.Varint ();
+            std::uint64_t size = reader.Varint ();
+
+            //Replay reads count values of the type from the payload, so the two must agree exactly
+            reader.failed |= count == 0 || count > INT32_MAX || size != count * UniformTypeSize (type);
+            reader.Bytes (size);
+            break;
+        }
+        default:
+            reader.failed = true;
+            break;
+        }
+    }
+
+    return !reader.failed;
+}
+
+std::unique_ptr<UniformTrace> UniformTrace::Load (const std::string& filename)
+{
+    std::ifstream stream (filename, std::ios::binary);
+
+    if (!stream.is_open ())
+    {
+        std::cerr << "Could not open uniform trace: " << filename << "\n";
+        return nullptr;
+    }
+
+    std::vector<unsigned char> contents ((std::istreambuf_iterator<char> (stream)), std::istreambuf_iterator<char> ());
+
+    if (contents.size () < sizeof (traceMagic) + 1 || std::memcmp (contents.data (), traceMagic, sizeof (traceMagic)) != 0 || contents[sizeof (traceMagic)] != traceVersion)
+    {
+        std::cerr << "Not a uniform trace of a supported version: " << filename << "\n";
+        return nullptr;
+    }
+
+    std::unique_ptr<UniformTrace> trace (new UniformTrace ());
+    trace->records.assign (contents.begin () + sizeof (traceMagic) + 1, contents.end ());
+
+    if (!trace->Validate ())
+    {
+        std::cerr << "Uniform trace is truncated or corrupt: " << filename << "\n";
+        return nullptr;
+    }
+
+    return trace;
+}
+
+bool UniformTrace::Save (const std::string& filename) const
+{
+    std::ofstream stream (filename, std::ios::binary | std::ios::trunc);
+
+    if (!stream.is_open ())
+    {
+        std::cerr << "Could not write uniform trace: " << filename << "\n";
+        return false;
+    }
+
+    stream.write (traceMagic, sizeof (traceMagic));
+    stream.put (static_cast<char> (traceVersion));
+    stream.write (reinterpret_cast<const char*> (records.data ()), records.size ());
+
+    return static_cast<bool> (stream);
+}
+
+template <typename T>
+void UniformTrace::ReplayWrite (const ShaderProgram& program, const std::string& uniformName, GLint element, GLsizei count, const unsigned char* bytes, std::vector<std::max_align_t>& scratch)
+{
+    //Values in the trace are unaligned; copy them out before reading them as T
+    scratch.resize ((count * sizeof (T) + sizeof (std::max_align_t) - 1) / sizeof (std::max_align_t));
+    std::memcpy (scratch.data (), bytes, count * sizeof (T));
+    program.StoreByName (uniformName, count, reinterpret_cast<const T*> (scratch.data ()), element);
+}
+
+UniformTrace::ReplayStats UniformTrace::Replay (const std::unordered_map<std::string, const ShaderProgram*>& programs) const
+{
+    ReplayStats stats = {};
+    TraceReader reader = { records.data (), records.data () + records.size () };
+
+    std::vector<const ShaderProgram*> resolvedPrograms;
+    std::vector<std::string> uniformNames;
+    std::vector<std::max_align_t> scratch;
+
+    while (!reader.AtEnd ())
+    {
+        switch (reader.Byte ())
+        {
+        case EndFrame:
+            stats.frames++;
+            break;
+        case DefineProgram:
+        {
+            std::uint64_t length = reader.Varint ();
+            const unsigned char* name = reader.Bytes (length);
+            auto it = programs.find (std::string (reinterpret_cast<const char*> (name), length));
+            resolvedPrograms.push_back (it != programs.end () ? it->second : nullptr);
+            break;
+        }
+        case DefineUniform:
+        {
+            std::uint64_t length = reader.Varint ();
+            const unsigned char* name = reader.Bytes (length);
+            uniformNames.emplace_back (reinterpret_cast<const char*> (name), length);
+            break;
+        }
+        case Bind:
+        {
+            const ShaderProgram* program = resolvedPrograms[reader.Varint ()];
+
+            if (!program)
+            {
+                stats.skipped++;
+                break;
+            }
+
+            program->UseProgram ();
+            stats.binds++;
+            break;
+        }
+        case Write:
+        {
+            const ShaderProgram* program = resolvedPrograms[reader.Varint ()];
+            const std::string& uniformName = uniformNames[reader.Varint ()];
+            GLenum type = static_cast<GLenum> (reader.Varint ());
+            GLint element = ZigzagDecode (reader.Varint ());
+            GLsizei count = static_cast<GLsizei> (reader.Varint ());
+            const unsigned char* bytes = reader.Bytes (reader.Varint ());
+
+            if (!program)
+            {
+                stats.skipped++;
+                break;
+            }
+
+            switch (type)
+            {
+            case GL_FLOAT: ReplayWrite<GLfloat> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_VEC2: ReplayWrite<glm::vec2> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_VEC3: ReplayWrite<glm::vec3> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_VEC4: ReplayWrite<glm::vec4> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_INT: ReplayWrite<GLint> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_INT_VEC2: ReplayWrite<glm::ivec2> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_INT_VEC3: ReplayWrite<glm::ivec3> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_INT_VEC4: ReplayWrite<glm::ivec4> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_UNSIGNED_INT: ReplayWrite<GLuint> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_UNSIGNED_INT_VEC2: ReplayWrite<glm::uvec2> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_UNSIGNED_INT_VEC3: ReplayWrite<glm::uvec3> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_UNSIGNED_INT_VEC4: ReplayWrite<glm::uvec4> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_MAT2: ReplayWrite<glm::mat2> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_MAT2x3: ReplayWrite<glm::mat2x3> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_MAT2x4: ReplayWrite<glm::mat2x4> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_MAT3x2: ReplayWrite<glm::mat3x2> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_MAT3: ReplayWrite<glm::mat3> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_MAT3x4: ReplayWrite<glm::mat3x4> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_MAT4x2: ReplayWrite<glm::mat4x2> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_MAT4x3: ReplayWrite<glm::mat4x3> (*program, uniformName, element, count, bytes, scratch); break;
+            case GL_FLOAT_MAT4: ReplayWrite<glm::mat4> (*program, uniformName, element, count, bytes, scratch); break;
+            default:
+                stats.skipped++;
+                continue;
+            }
+
+            stats.writes++;
+            break;
+        }
+        }
+    }
+
+    return stats;
+}
+
+std::uint64_t UniformTrace::GetFrameCount () const
+{
+    return frameCount;
+}
+
+size_t UniformTrace::GetSize () const
+{
+    return sizeof (traceMagic) + 1 + records.size ();
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+class ShaderProgram;
+
+/// <summary>
+/// A capture of the UseProgram calls and uniform writes an application makes, frame by frame, in a compact binary form that
+/// can be saved, loaded and replayed against ShaderProgram on any GL backend. Redundant calls are captured as made, so a replay
+/// reproduces the application's workload for the shadow cache and the bind tracking. Capture and replay on the GL thread only.
+/// </summary>
+class UniformTrace
+{
+public:
+    /// <summary>
+    /// Counts what a replay did: frames, UseProgram calls and uniform writes issued, and records skipped because their
+    /// program was not supplied.
+    /// </summary>
+    struct ReplayStats
+    {
+        std::uint64_t frames;
+        std::uint64_t binds;
+        std::uint64_t writes;
+        std::uint64_t skipped;
+    };
+
+private:
+    // Record opcodes; names are defined inline the first time they are used, and later records refer to them by index
+    enum Opcode : unsigned char
+    {
+        EndFrame = 1,
+        DefineProgram = 2,
+        DefineUniform = 3,
+        Bind = 4,
+        Write = 5
+    };
+
+    static std::unique_ptr<UniformTrace> capture;
+
+    std::vector<unsigned char> records;
+    std::uint64_t frameCount = 0;
+
+    // Name to index maps, used while capturing
+    std::unordered_map<std::string, std::uint32_t> programIndices;
+    std::unordered_map<std::string, std::uint32_t> uniformIndices;
+
+    UniformTrace () = default;
+
+    void WriteVarint (std::uint64_t value);
+    std::uint32_t Intern (std::unordered_map<std::string, std::uint32_t>& indices, Opcode opcode, const std::string& name);
+    bool Validate ();
+
+    template <typename T>
+    static void ReplayWrite (const ShaderProgram& program, const std::string& uniformName, GLint element, GLsizei count, const unsigned char* bytes, std::vector<std::max_align_t>& scratch);
+
+public:
+    /// <summary>
+    /// Starts capturing. Exits if a capture is already running.
+    /// </summary>
+    static void BeginCapture ();
+
+    /// <summary>
+    /// Stops capturing and returns the captured trace, or null if no capture was running.
+    /// </summary>
+    static std::unique_ptr<UniformTrace> EndCapture ();
+
+    /// <summary>
+    /// Returns whether a capture is running.
+    /// </summary>
+    static bool IsCapturing ()
+    {
+        return capture != nullptr;
+    }
+
+    /// <summary>
+    /// Marks the end of a frame in the running capture. Does nothing when not capturing.
+    /// </summary>
+    static void MarkFrame ();
+
+    /// <summary>
+    /// Loads a trace written by Save. Returns null, after reporting why, if the file cannot be read or is not a valid trace.
+    /// </summary>
+    static std::unique_ptr<UniformTrace> Load (const std::string& filename);
+
+    /// <summary>
+    /// Writes the trace to a file. Returns false, after reporting why, if the file cannot be written.
+    /// </summary>
+    bool Save (const std::string& filename) const;
+
+    /// <summary>
+    /// Replays the trace: every captured UseProgram and uniform write is made again, in order, on the program of the same name.
+    /// Records of programs that are not supplied are skipped.
+    /// </summary>
+    /// <param name="programs">The programs to replay against, keyed by program name.</param>
+    ReplayStats Replay (const std::unordered_map<std::string, const ShaderProgram*>& programs) const;
+
+    /// <summary>
+    /// Returns the number of frames in the trace. Calls after the last MarkFrame belong to a final, unterminated frame that is not counted.
+    /// </summary>
+    std::uint64_t GetFrameCount () const;
+
+    /// <summary>
+    /// Returns the size of the trace in bytes, as written by Save.
+    /// </summary>
+    size_t GetSize () const;
+
+    /// <summary>
+    /// Called by ShaderProgram when UseProgram is called during a capture.
+    /// </summary>
+    static void RecordBind (const std::string& programName);
+
+    /// <summary>
+    /// Called by ShaderProgram when a uniform is written during a capture, before the shadow cache sees the write.
+    /// </summary>
+    /// <param name="programName">The program written to.</param>
+    /// <param name="uniformName">The uniform name, as looked up by the setter.</param>
+    /// <param name="type">The GLSL type of the values, as UniformTraits&lt;T&gt;::glslType.</param>
+    /// <param name="element">The first array element written.</param>
+    /// <param name="count">The number of elements written.</param>
+    /// <param name="data">The values.</param>
+    /// <param name="size">The size of the values in bytes.</param>
+    static void RecordWrite (const std::string& programName, const std::string& uniformName, GLenum type, GLint element, GLsizei count, const void* data, size_t size);
+};
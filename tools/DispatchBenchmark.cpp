@@ -0,0 +1,110 @@
+//Measures the CPU cost of the library itself on the null GL backend: uniform setter throughput, uniform lookup, source loading
+//and factory creation. Each operation is also run once on the recording backend to count the GL calls it makes in steady state.
+//Build it on its own, alongside the library sources, and link against GLEW; it creates no GL context and needs no GPU.
+//
+//Usage: DispatchBenchmark [iterations scale, default 1]
+//
+//The shaders it builds are written to the current directory as DispatchBenchmark.vert and DispatchBenchmark.frag.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../GLDispatch.h"
+#include "../ShaderProgram.h"
+#include "../ShaderSource.h"
+
+static const char* vertexSource =
+    "#version 330 core\n"
+    "uniform mat4 mvp;\n"
+    "uniform vec4 bones[64];\n"
+    "layout (std140) uniform Camera { mat4 view; };\n"
+    "uniform float blend, weights[3];\n"
+    "in vec4 position;\n"
+    "void main () { gl_Position = mvp * bones[0] * position * blend * weights[2]; }\n";
+
+static const char* fragmentSource =
+    "#version 330 core\n"
+    "uniform sampler2D albedo;\n"
+    "uniform vec3 tint;\n"
+    "uniform mat4 mvp;\n"
+    "out vec4 color;\n"
+    "void main () { color = texture (albedo, vec2 (0.0)) * vec4 (tint, 1.0); }\n";
+
+static double iterationScale = 1.0;
+
+/// <summary>
+/// Runs an operation once to warm up, once on the recording backend to count the GL calls it makes in steady state, and
+/// then times it on the null backend. The operation receives the iteration number, so it can vary the values it writes.
+/// </summary>
+template <typename Operation>
+static void Measure (const char* name, int iterations, Operation operation)
+{
+    GLDispatch::Install (GLDispatch::Null ());
+    operation (0);
+
+    GLDispatch::Install (GLDispatch::Recording (GLDispatch::Null ()));
+    GLDispatch::ClearRecordedCalls ();
+    operation (1);
+    size_t calls = GLDispatch::GetRecordedCalls ().size ();
+    GLDispatch::ClearRecordedCalls ();
+
+    GLDispatch::Install (GLDispatch::Null ());
+    iterations = std::max (1, static_cast<int> (iterations * iterationScale));
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
+    for (int i = 2; i < iterations + 2; i++)
+        operation (i);
+
+    double nanoseconds = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - start).count () / iterations;
+    std::printf ("%-36s %10.1f ns/op %6zu GL calls/op\n", name, nanoseconds, calls);
+}
+
+int main (int argc, char** argv)
+{
+    if (argc > 1)
+        iterationScale = std::atof (argv[1]);
+
+    if (iterationScale <= 0.0)
+    {
+        std::fprintf (stderr, "Usage: DispatchBenchmark [iterations scale, default 1]\n");
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream ("DispatchBenchmark.vert") << vertexSource;
+    std::ofstream ("DispatchBenchmark.frag") << fragmentSource;
+
+    GLDispatch::Install (GLDispatch::Null ());
+    std::unique_ptr<ShaderProgram> program = ShaderProgram::CreateBasicShaderProgram ("DispatchBenchmark");
+    program->UseProgram ();
+
+    UniformHandle<glm::mat4> mvp = program->GetUniform<glm::mat4> ("mvp");
+    std::vector<glm::vec4> bones (64);
+    glm::mat4 matrix (1.0f);
+
+    std::printf ("Uniform setters\n");
+    Measure ("SetUniformFloat, changing value", 1000000, [&] (int i) { program->SetUniformFloat ("blend", static_cast<float> (i)); });
+    Measure ("SetUniformFloat, same value", 1000000, [&] (int) { program->SetUniformFloat ("blend", 1.0f); });
+    Measure ("Set (handle), mat4, changing value", 1000000, [&] (int i) { matrix[3][0] = static_cast<float> (i); program->Set (mvp, matrix); });
+    Measure ("SetUniformVec4Array, 64 elements", 200000, [&] (int i) { bones[i & 63][0] = static_cast<float> (i); program->SetUniformVec4Array ("bones", bones); });
+
+    std::printf ("Uniform lookup\n");
+    Measure ("FindUniform", 1000000, [&] (int) { const ShaderProgram::UniformInfo* volatile uniform = program->FindUniform ("mvp"); (void) uniform; });
+    Measure ("GetUniformLocation", 1000000, [&] (int) { volatile GLint location = program->GetUniformLocation ("tint"); (void) location; });
+    Measure ("GetUniform, array element", 200000, [&] (int) { volatile GLint location = program->GetUniform<glm::vec4> ("bones[7]").GetLocation (); (void) location; });
+
+    std::printf ("Source loading\n");
+    Measure ("ShaderSource, cached fragments", 100000, [&] (int) { ShaderSource source ("DispatchBenchmark.vert"); });
+    Measure ("ShaderSource, file read", 20000, [&] (int) { ShaderSource::InvalidateFile ("DispatchBenchmark.vert"); ShaderSource source ("DispatchBenchmark.vert"); });
+
+    std::printf ("Factory creation\n");
+    Measure ("CreateBasicShaderProgram", 20000, [&] (int) { std::unique_ptr<ShaderProgram> created = ShaderProgram::CreateBasicShaderProgram ("DispatchBenchmark"); });
+
+    return EXIT_SUCCESS;
+}
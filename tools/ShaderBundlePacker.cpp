@@ -0,0 +1,138 @@
+//Packs shader files, and optionally the program binary cache, into a bundle that ShaderBundle::Mount can map at startup.
+//Build it on its own, alongside ShaderBundle.cpp, ShaderSource.cpp and SourceFile.cpp; it needs no GL context.
+//
+//Usage: ShaderBundlePacker [-C directory] [--binaries cacheDirectory] output.bundle (file | directory)...
+//
+//Files are stored under their path relative to the -C directory, which defaults to the current one, so run it from the directory
+//the application resolves its shader filenames against. Directories are packed recursively. Binaries are only valid for the
+//driver they were built by; pack them from a cache directory filled on the target machine.
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../ShaderBundle.h"
+
+namespace fs = std::filesystem;
+
+static bool ReadContents (const fs::path& path, std::vector<char>& contents)
+{
+    std::ifstream stream (path, std::ios::binary);
+
+    if (!stream.is_open ())
+    {
+        std::cerr << "Could not open file: " << path.string () << "\n";
+        return false;
+    }
+
+    contents.assign (std::istreambuf_iterator<char> (stream), std::istreambuf_iterator<char> ());
+    return true;
+}
+
+static bool AddFile (const fs::path& root, const fs::path& path, std::vector<ShaderBundle::PackedEntry>& entries)
+{
+    ShaderBundle::PackedEntry entry = { ShaderBundle::EntryKind::File, path.generic_string (), {} };
+
+    if (!ReadContents (root / path, entry.contents))
+        return false;
+
+    entries.push_back (std::move (entry));
+    return true;
+}
+
+static bool AddBinaries (const fs::path& directory, std::vector<ShaderBundle::PackedEntry>& entries)
+{
+    std::error_code error;
+    fs::directory_iterator it (directory, error);
+
+    if (error)
+    {
+        std::cerr << "Could not read binary cache directory: " << directory.string () << "\n";
+        return false;
+    }
+
+    for (const fs::directory_entry& file : it)
+    {
+        //Cached binaries are named by their key; anything else, such as an interrupted .tmp write, is not a binary
+        if (!file.is_regular_file () || file.path ().extension () != ".bin")
+            continue;
+
+        ShaderBundle::PackedEntry entry = { ShaderBundle::EntryKind::Binary, file.path ().stem ().string (), {} };
+
+        if (!ReadContents (file.path (), entry.contents))
+            return false;
+
+        entries.push_back (std::move (entry));
+    }
+
+    return true;
+}
+
+int main (int argc, char** argv)
+{
+    fs::path root = ".";
+    fs::path binaryDirectory;
+    std::string output;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+
+        if (argument == "-C" && i + 1 < argc)
+            root = argv[++i];
+        else if (argument == "--binaries" && i + 1 < argc)
+            binaryDirectory = argv[++i];
+        else if (output.empty ())
+            output = argument;
+        else
+            inputs.push_back (argument);
+    }
+
+    if (output.empty () || (inputs.empty () && binaryDirectory.empty ()))
+    {
+        std::cerr << "Usage: ShaderBundlePacker [-C directory] [--binaries cacheDirectory] output.bundle (file | directory)...\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<ShaderBundle::PackedEntry> entries;
+
+    for (const std::string& input : inputs)
+    {
+        fs::path path = input;
+        std::error_code error;
+
+        if (!fs::is_directory (root / path, error))
+        {
+            if (!AddFile (root, path, entries))
+                return EXIT_FAILURE;
+
+            continue;
+        }
+
+        for (const fs::directory_entry& file : fs::recursive_directory_iterator (root / path, error))
+        {
+            if (file.is_regular_file () && !AddFile (root, file.path ().lexically_relative (root), entries))
+                return EXIT_FAILURE;
+        }
+
+        if (error)
+        {
+            std::cerr << "Could not read directory: " << (root / path).string () << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!binaryDirectory.empty () && !AddBinaries (binaryDirectory, entries))
+        return EXIT_FAILURE;
+
+    if (!ShaderBundle::Write (output, entries))
+        return EXIT_FAILURE;
+
+    std::cout << "Packed " << entries.size () << " entries into " << output << "\n";
+    return EXIT_SUCCESS;
+}
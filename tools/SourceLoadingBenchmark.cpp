@@ -0,0 +1,134 @@
+//Compares ways of handing a large shader file to glShaderSource: line by line, with a heap copy of every line as the loader
+//used to make, as one buffer mapped with SourceFile, and through ShaderSource with its fragment cache dropped before each load.
+//Build it on its own, alongside the library sources, and link against GLEW; it creates no GL context and needs no GPU. The
+//driver is stood in for by a null backend whose glShaderSource copies the strings into one, as a driver must.
+//
+//Usage: SourceLoadingBenchmark [lines, default 50000] [loads, default 50]
+//
+//The shader it loads is generated in the current directory as SourceLoadingBenchmark.vert.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../GLDispatch.h"
+#include "../ShaderSource.h"
+#include "../SourceFile.h"
+
+static const char* filename = "SourceLoadingBenchmark.vert";
+
+static size_t copiedBytes = 0;
+
+static void CopyShaderSource (GLuint, GLsizei count, const GLchar* const* strings, const GLint* lengths)
+{
+    std::string source;
+
+    for (GLsizei i = 0; i < count; i++)
+    {
+        if (lengths && lengths[i] >= 0)
+            source.append (strings[i], lengths[i]);
+        else
+            source.append (strings[i]);
+    }
+
+    copiedBytes += source.size ();
+}
+
+static void LoadPerLine (GLuint shaderID)
+{
+    std::ifstream stream (filename);
+    std::vector<std::string> lines;
+    std::string line;
+
+    while (std::getline (stream, line))
+        lines.push_back (line);
+
+    GLchar** strings = new GLchar*[lines.size ()];
+
+    for (size_t i = 0; i < lines.size (); i++)
+    {
+        size_t length = lines[i].length ();
+        strings[i] = new GLchar[length + 2];
+        lines[i].copy (strings[i], length);
+        strings[i][length] = '\n';
+        strings[i][length + 1] = '\0';
+    }
+
+    GL ().ShaderSource (shaderID, static_cast<GLsizei> (lines.size ()), strings, nullptr);
+
+    for (size_t i = 0; i < lines.size (); i++)
+        delete[] strings[i];
+
+    delete[] strings;
+}
+
+static void LoadSingleBuffer (GLuint shaderID)
+{
+    SourceFile file (filename);
+    const GLchar* data = file.GetData ();
+    GLint length = static_cast<GLint> (file.GetSize ());
+
+    GL ().ShaderSource (shaderID, 1, &data, &length);
+}
+
+static void LoadShaderSource (GLuint shaderID)
+{
+    ShaderSource::InvalidateFile (filename);
+    ShaderSource source (filename);
+
+    GL ().ShaderSource (shaderID, source.GetStringCount (), source.GetStrings (), source.GetLengths ());
+}
+
+static void Measure (const char* name, int loads, GLuint shaderID, void (*load) (GLuint))
+{
+    //The first load warms the page cache, so every method reads the file from memory
+    load (shaderID);
+    copiedBytes = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
+    for (int i = 0; i < loads; i++)
+        load (shaderID);
+
+    double milliseconds = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count () / loads;
+    std::printf ("%-24s %10.3f ms/load %12zu bytes/load\n", name, milliseconds, copiedBytes / loads);
+}
+
+int main (int argc, char** argv)
+{
+    int lineCount = argc > 1 ? std::atoi (argv[1]) : 50000;
+    int loads = argc > 2 ? std::atoi (argv[2]) : 50;
+
+    if (lineCount <= 0 || loads <= 0)
+    {
+        std::fprintf (stderr, "Usage: SourceLoadingBenchmark [lines, default 50000] [loads, default 50]\n");
+        return EXIT_FAILURE;
+    }
+
+    {
+        std::ofstream stream (filename);
+        stream << "#version 330 core\n";
+
+        for (int i = 0; i < lineCount; i++)
+            stream << "const vec4 generated" << i << " = vec4 (" << i << ".0, 1.0, 2.0, 3.0);\n";
+
+        stream << "void main () { gl_Position = generated0; }\n";
+    }
+
+    GLDispatch table = GLDispatch::Null ();
+    table.ShaderSource = CopyShaderSource;
+    GLDispatch::Install (table);
+
+    GLuint shaderID = GL ().CreateShader (GL_VERTEX_SHADER);
+
+    std::printf ("%d lines, %d loads\n", lineCount + 2, loads);
+    Measure ("Per line", loads, shaderID, LoadPerLine);
+    Measure ("Single buffer", loads, shaderID, LoadSingleBuffer);
+    Measure ("ShaderSource", loads, shaderID, LoadShaderSource);
+
+    GL ().DeleteShader (shaderID);
+    return EXIT_SUCCESS;
+}
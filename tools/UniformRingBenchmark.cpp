@@ -0,0 +1,208 @@
+//Compares ways of giving every draw its own model matrix and tint: SetUniformMat4 and SetUniformVec4 by name, Set with uniform
+//handles, and a UniformRing pushing a std140 block per draw. Each frame issues the draws into a small offscreen framebuffer and
+//waits for them with glFinish, so the times include the driver's work as well as the library's.
+//Build it on its own, alongside the library sources, and link against GLEW and EGL; it creates a headless GL 4.5 core context,
+//so it needs a driver with EGL support but no window or display.
+//
+//Usage: UniformRingBenchmark [draws per frame, default 2000] [frames, default 100]
+//
+//The shaders it builds are written to the current directory as UniformRingBenchmark.vert and UniformRingBenchmark.frag.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "../ShaderProgram.h"
+#include "../Std140.h"
+#include "../UniformRing.h"
+
+static const char* vertexSource =
+    "#version 330 core\n"
+    "uniform mat4 model;\n"
+    "uniform vec4 tint;\n"
+    "layout (std140) uniform Draw { mat4 drawModel; vec4 drawTint; };\n"
+    "out vec4 color;\n"
+    "void main () { gl_Position = model * drawModel * vec4 (0.0, 0.0, 0.0, 1.0); color = tint + drawTint; }\n";
+
+static const char* fragmentSource =
+    "#version 330 core\n"
+    "in vec4 color;\n"
+    "out vec4 fragmentColor;\n"
+    "void main () { fragmentColor = color; }\n";
+
+typedef Std140Layout<glm::mat4, glm::vec4> DrawLayout;
+
+static bool CreateContext ()
+{
+    //Prefer Mesa's surfaceless platform, which needs no display server, and fall back to the default display
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC> (eglGetProcAddress ("eglGetPlatformDisplayEXT"));
+
+    if (getPlatformDisplay)
+        display = getPlatformDisplay (EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+    if (display == EGL_NO_DISPLAY || !eglInitialize (display, nullptr, nullptr))
+    {
+        display = eglGetDisplay (EGL_DEFAULT_DISPLAY);
+
+        if (display == EGL_NO_DISPLAY || !eglInitialize (display, nullptr, nullptr))
+            return false;
+    }
+
+    const EGLint contextAttributes[] =
+    {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    if (!eglBindAPI (EGL_OPENGL_API))
+        return false;
+
+    EGLContext context = eglCreateContext (display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+
+    return context != EGL_NO_CONTEXT && eglMakeCurrent (display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+}
+
+template <typename DrawFrame>
+static void Measure (const char* name, int frames, int draws, DrawFrame drawFrame)
+{
+    //The first frame warms up the driver's shader variants and buffer allocations
+    drawFrame ();
+    glFinish ();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
+    for (int i = 0; i < frames; i++)
+    {
+        drawFrame ();
+        glFinish ();
+    }
+
+    double milliseconds = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count () / frames;
+    std::printf ("%-28s %8.3f ms/frame %8.1f ns/draw\n", name, milliseconds, milliseconds * 1e6 / draws);
+}
+
+int main (int argc, char** argv)
+{
+    int draws = argc > 1 ? std::atoi (argv[1]) : 2000;
+    int frames = argc > 2 ? std::atoi (argv[2]) : 100;
+
+    if (draws <= 0 || frames <= 0)
+    {
+        std::fprintf (stderr, "Usage: UniformRingBenchmark [draws per frame, default 2000] [frames, default 100]\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!CreateContext ())
+    {
+        std::fprintf (stderr, "Could not create a headless GL 4.5 context through EGL\n");
+        return EXIT_FAILURE;
+    }
+
+    //GLEW reports a missing GLX display for EGL contexts after loading the entry points it needs
+    glewExperimental = GL_TRUE;
+    GLenum glewError = glewInit ();
+
+    if (glewError != GLEW_OK && glewError != GLEW_ERROR_NO_GLX_DISPLAY)
+    {
+        std::fprintf (stderr, "Could not initialize GLEW: %s\n", reinterpret_cast<const char*> (glewGetErrorString (glewError)));
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream ("UniformRingBenchmark.vert") << vertexSource;
+    std::ofstream ("UniformRingBenchmark.frag") << fragmentSource;
+
+    GLuint framebufferID, renderbufferID, vertexArrayID;
+    glGenRenderbuffers (1, &renderbufferID);
+    glBindRenderbuffer (GL_RENDERBUFFER, renderbufferID);
+    glRenderbufferStorage (GL_RENDERBUFFER, GL_RGBA8, 64, 64);
+    glGenFramebuffers (1, &framebufferID);
+    glBindFramebuffer (GL_FRAMEBUFFER, framebufferID);
+    glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbufferID);
+    glViewport (0, 0, 64, 64);
+    glGenVertexArrays (1, &vertexArrayID);
+    glBindVertexArray (vertexArrayID);
+
+    std::unique_ptr<ShaderProgram> program = ShaderProgram::CreateBasicShaderProgram ("UniformRingBenchmark");
+    program->UseProgram ();
+
+    std::unique_ptr<UniformRing> ring = UniformRing::Create (*program, "Draw", draws);
+    UniformHandle<glm::mat4> model = program->GetUniform<glm::mat4> ("model");
+    UniformHandle<glm::vec4> tint = program->GetUniform<glm::vec4> ("tint");
+
+    //Every draw gets distinct values, so the shadow cache never skips a write
+    std::vector<glm::mat4> models (draws, glm::mat4 (1.0f));
+    std::vector<glm::vec4> tints (draws);
+
+    for (int i = 0; i < draws; i++)
+    {
+        models[i][3][0] = static_cast<float> (i) / draws;
+        tints[i][0] = static_cast<float> (i) / draws;
+    }
+
+    glm::mat4 identity (1.0f);
+    glm::vec4 zero (0.0f);
+
+    std::printf ("%d draws per frame, %d frames\n", draws, frames);
+
+    //Each path sets its own values and leaves the other path's at a neutral value, as an application using one of them would
+    ring->BeginFrame ();
+    ring->Push<DrawLayout> (identity, zero);
+    ring->EndFrame ();
+
+    Measure ("SetUniformMat4/Vec4 by name", frames, draws, [&] ()
+    {
+        for (int i = 0; i < draws; i++)
+        {
+            program->SetUniformMat4 ("model", models[i]);
+            program->SetUniformVec4 ("tint", tints[i]);
+            glDrawArrays (GL_POINTS, 0, 1);
+        }
+    });
+
+    Measure ("Set with uniform handles", frames, draws, [&] ()
+    {
+        for (int i = 0; i < draws; i++)
+        {
+            program->Set (model, models[i]);
+            program->Set (tint, tints[i]);
+            glDrawArrays (GL_POINTS, 0, 1);
+        }
+    });
+
+    program->SetUniformMat4 ("model", identity);
+    program->SetUniformVec4 ("tint", zero);
+
+    Measure ("UniformRing push", frames, draws, [&] ()
+    {
+        ring->BeginFrame ();
+
+        for (int i = 0; i < draws; i++)
+        {
+            ring->Push<DrawLayout> (models[i], tints[i]);
+            glDrawArrays (GL_POINTS, 0, 1);
+        }
+
+        ring->EndFrame ();
+    });
+
+    UniformRing::RingStats stats = ring->GetStats ();
+    std::printf ("Ring: %llu pushes, %llu stalls\n", static_cast<unsigned long long> (stats.pushes), static_cast<unsigned long long> (stats.stalls));
+
+    ring.reset ();
+    program.reset ();
+    glDeleteVertexArrays (1, &vertexArrayID);
+    glDeleteFramebuffers (1, &framebufferID);
+    glDeleteRenderbuffers (1, &renderbufferID);
+
+    return EXIT_SUCCESS;
+}